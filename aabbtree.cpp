@@ -0,0 +1,464 @@
+#include "aabbtree.h"
+#include "bounds.h"
+#include "gameobject.h"
+#include <glm/common.hpp>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace
+{
+	// Surface area heuristic used to decide where leaves are inserted
+	float surfaceArea(const glm::vec3& min, const glm::vec3& max)
+	{
+		const auto d{max - min};
+
+		return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+	}
+
+	float unionArea(const glm::vec3& minA, const glm::vec3& maxA, const glm::vec3& minB, const glm::vec3& maxB)
+	{
+		return surfaceArea(glm::min(minA, minB), glm::max(maxA, maxB));
+	}
+
+	// Deepest traversal stack needed by a query -- the tree is kept balanced, so its height grows logarithmically with the number of objects
+	constexpr auto maxStackSize{256};
+}
+
+AabbTree::AabbTree(float fatMargin) : fatMargin_{fatMargin}, nodes_{}, root_{-1}, freeList_{-1}, deferUpdates_{false}
+{
+}
+
+// Create a leaf for the object and insert it into the tree
+void AabbTree::insert(GameObject& object)
+{
+	const auto leaf{allocateNode()};
+	nodes_[leaf].Object = &object;
+	nodes_[leaf].Height = 0;
+	setFatBox(leaf, object.getPosition(), object.getSize());
+
+	insertLeaf(leaf);
+
+	object.setBroadphase(this, leaf);
+}
+
+// Remove the object's leaf from the tree
+void AabbTree::remove(GameObject& object)
+{
+	const auto leaf{object.getBroadphaseProxy()};
+	if (leaf < 0 || leaf >= static_cast<int>(nodes_.size()) || nodes_[leaf].Object != &object)
+		return;
+
+	removeLeaf(leaf);
+	freeNode(leaf);
+
+	object.setBroadphase(nullptr, -1);
+}
+
+// Leaves keep their proxy id when reinserted, so registered objects don't need relinking
+void AabbTree::update(int proxy, const glm::vec3& position, const glm::vec3& size)
+{
+	const auto& leaf{nodes_[proxy]};
+	const auto max{position + size};
+
+	// Still inside the fat box, so the tree remains valid
+	if (position.x >= leaf.Min.x && position.y >= leaf.Min.y && position.z >= leaf.Min.z &&
+		max.x <= leaf.Max.x && max.y <= leaf.Max.y && max.z <= leaf.Max.z)
+		return;
+
+	// Each object only ever writes to its own leaf here, so this is safe to do concurrently
+	if (deferUpdates_)
+	{
+		nodes_[proxy].Moved = true;
+
+		return;
+	}
+
+	removeLeaf(proxy);
+	setFatBox(proxy, position, size);
+	insertLeaf(proxy);
+}
+
+void AabbTree::query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const
+{
+	queryTree([&min, &max](const Node& node) { return overlapsBox(node.Min, node.Max, min, max); }, results);
+}
+
+void AabbTree::querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const
+{
+	const auto radiusSquared{radius * radius};
+
+	queryTree([&centre, radiusSquared](const Node& node) { return overlapsSphere(node.Min, node.Max, centre, radiusSquared); }, results);
+}
+
+void AabbTree::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const
+{
+	const auto inverseDirection{1.0f / direction};
+
+	queryTree([&origin, &inverseDirection, maxDistance](const Node& node) { return overlapsRay(node.Min, node.Max, origin, inverseDirection, maxDistance); }, results);
+}
+
+int AabbTree::getHeight() const
+{
+	return root_ == -1 ? 0 : nodes_[root_].Height;
+}
+
+void AabbTree::setDeferUpdates(bool defer)
+{
+	deferUpdates_ = defer;
+
+	if (defer)
+		return;
+
+	// Refit leaves flagged while deferred, using their objects' latest collision boxes
+	for (auto i{0}; i < static_cast<int>(nodes_.size()); ++i)
+	{
+		if (!nodes_[i].Moved)
+			continue;
+
+		nodes_[i].Moved = false;
+
+		const auto& object{*nodes_[i].Object};
+		update(i, object.getPosition(), object.getSize());
+	}
+}
+
+// Walk the tree, descending only into nodes accepted by the overlap test. Results are sorted by proxy id so they follow insertion order, keeping collision resolution order stable
+template<typename Overlaps>
+void AabbTree::queryTree(const Overlaps& overlaps, std::vector<GameObject*>& results) const
+{
+	if (root_ == -1)
+		return;
+
+	int stack[maxStackSize]{};
+	auto stackSize{0};
+	stack[stackSize++] = root_;
+
+	int found[maxStackSize]{};
+	auto foundCount{0};
+	const auto flush{[&]()
+	{
+		std::sort(found, found + foundCount);
+		for (auto i{0}; i < foundCount; ++i)
+			results.push_back(nodes_[found[i]].Object);
+		foundCount = 0;
+	}};
+
+	while (stackSize > 0)
+	{
+		const auto index{stack[--stackSize]};
+		const auto& node{nodes_[index]};
+
+		if (!overlaps(node))
+			continue;
+
+		if (node.isLeaf())
+		{
+			// Batches of results are sorted independently if a query returns a very large number of objects
+			if (foundCount == maxStackSize)
+				flush();
+
+			found[foundCount++] = index;
+		}
+		else
+		{
+			assert(stackSize + 2 <= maxStackSize);
+
+			stack[stackSize++] = node.Right;
+			stack[stackSize++] = node.Left;
+		}
+	}
+
+	flush();
+}
+
+// Get an unused node, reusing freed nodes where possible
+int AabbTree::allocateNode()
+{
+	if (freeList_ == -1)
+	{
+		nodes_.emplace_back();
+
+		return static_cast<int>(nodes_.size()) - 1;
+	}
+
+	const auto node{freeList_};
+	freeList_ = nodes_[node].Parent;
+	nodes_[node] = Node{};
+
+	return node;
+}
+
+void AabbTree::freeNode(int node)
+{
+	nodes_[node] = Node{};
+	nodes_[node].Parent = freeList_;
+	freeList_ = node;
+}
+
+// Insert a leaf next to the sibling that increases the total surface area of the tree the least
+void AabbTree::insertLeaf(int leaf)
+{
+	if (root_ == -1)
+	{
+		root_ = leaf;
+		nodes_[leaf].Parent = -1;
+
+		return;
+	}
+
+	const auto leafMin{nodes_[leaf].Min};
+	const auto leafMax{nodes_[leaf].Max};
+
+	// Descend the tree to find the best sibling
+	auto index{root_};
+	while (!nodes_[index].isLeaf())
+	{
+		const auto& node{nodes_[index]};
+		const auto area{surfaceArea(node.Min, node.Max)};
+		const auto combinedArea{unionArea(node.Min, node.Max, leafMin, leafMax)};
+
+		// Cost of creating a new parent for this node and the new leaf
+		const auto cost{2.0f * combinedArea};
+
+		// Minimum cost of pushing the leaf further down the tree
+		const auto inheritanceCost{2.0f * (combinedArea - area)};
+
+		const auto getDescendCost{[&](int child)
+		{
+			const auto& childNode{nodes_[child]};
+			const auto childArea{unionArea(childNode.Min, childNode.Max, leafMin, leafMax)};
+
+			if (childNode.isLeaf())
+				return childArea + inheritanceCost;
+
+			return childArea - surfaceArea(childNode.Min, childNode.Max) + inheritanceCost;
+		}};
+
+		const auto costLeft{getDescendCost(node.Left)};
+		const auto costRight{getDescendCost(node.Right)};
+
+		if (cost < costLeft && cost < costRight)
+			break;
+
+		index = costLeft < costRight ? node.Left : node.Right;
+	}
+
+	const auto sibling{index};
+
+	// Create a new parent for the sibling and the leaf
+	const auto oldParent{nodes_[sibling].Parent};
+	const auto newParent{allocateNode()};
+	nodes_[newParent].Parent = oldParent;
+	nodes_[newParent].Min = glm::min(leafMin, nodes_[sibling].Min);
+	nodes_[newParent].Max = glm::max(leafMax, nodes_[sibling].Max);
+	nodes_[newParent].Height = nodes_[sibling].Height + 1;
+	nodes_[newParent].Left = sibling;
+	nodes_[newParent].Right = leaf;
+
+	if (oldParent != -1)
+	{
+		if (nodes_[oldParent].Left == sibling)
+			nodes_[oldParent].Left = newParent;
+		else
+			nodes_[oldParent].Right = newParent;
+	}
+	else
+		root_ = newParent;
+
+	nodes_[sibling].Parent = newParent;
+	nodes_[leaf].Parent = newParent;
+
+	// Walk back up the tree, rebalancing and fixing heights and boxes
+	refit(nodes_[leaf].Parent);
+}
+
+// Detach a leaf, replacing its parent with its sibling
+void AabbTree::removeLeaf(int leaf)
+{
+	if (leaf == root_)
+	{
+		root_ = -1;
+
+		return;
+	}
+
+	const auto parent{nodes_[leaf].Parent};
+	const auto grandParent{nodes_[parent].Parent};
+	const auto sibling{nodes_[parent].Left == leaf ? nodes_[parent].Right : nodes_[parent].Left};
+
+	if (grandParent != -1)
+	{
+		if (nodes_[grandParent].Left == parent)
+			nodes_[grandParent].Left = sibling;
+		else
+			nodes_[grandParent].Right = sibling;
+
+		nodes_[sibling].Parent = grandParent;
+		freeNode(parent);
+
+		refit(grandParent);
+	}
+	else
+	{
+		root_ = sibling;
+		nodes_[sibling].Parent = -1;
+		freeNode(parent);
+	}
+}
+
+// Rebalance and recompute the boxes and heights of the given node and all its ancestors
+void AabbTree::refit(int node)
+{
+	auto index{node};
+	while (index != -1)
+	{
+		index = balance(index);
+
+		auto& current{nodes_[index]};
+		const auto& left{nodes_[current.Left]};
+		const auto& right{nodes_[current.Right]};
+
+		current.Height = 1 + std::max(left.Height, right.Height);
+		current.Min = glm::min(left.Min, right.Min);
+		current.Max = glm::max(left.Max, right.Max);
+
+		index = current.Parent;
+	}
+}
+
+// Perform a left or right rotation if the subtree rooted at the given node is imbalanced. Returns the new root of the subtree
+int AabbTree::balance(int node)
+{
+	const auto iA{node};
+	auto& a{nodes_[iA]};
+
+	if (a.isLeaf() || a.Height < 2)
+		return iA;
+
+	const auto iB{a.Left};
+	const auto iC{a.Right};
+	auto& b{nodes_[iB]};
+	auto& c{nodes_[iC]};
+
+	const auto heightDifference{c.Height - b.Height};
+
+	// Rotate C up
+	if (heightDifference > 1)
+	{
+		const auto iF{c.Left};
+		const auto iG{c.Right};
+		auto& f{nodes_[iF]};
+		auto& g{nodes_[iG]};
+
+		// Swap A and C
+		c.Left = iA;
+		c.Parent = a.Parent;
+		a.Parent = iC;
+
+		// A's old parent should point to C
+		if (c.Parent != -1)
+		{
+			if (nodes_[c.Parent].Left == iA)
+				nodes_[c.Parent].Left = iC;
+			else
+				nodes_[c.Parent].Right = iC;
+		}
+		else
+			root_ = iC;
+
+		// Move the taller of C's children up alongside A
+		if (f.Height > g.Height)
+		{
+			c.Right = iF;
+			a.Right = iG;
+			g.Parent = iA;
+			a.Min = glm::min(b.Min, g.Min);
+			a.Max = glm::max(b.Max, g.Max);
+			c.Min = glm::min(a.Min, f.Min);
+			c.Max = glm::max(a.Max, f.Max);
+
+			a.Height = 1 + std::max(b.Height, g.Height);
+			c.Height = 1 + std::max(a.Height, f.Height);
+		}
+		else
+		{
+			c.Right = iG;
+			a.Right = iF;
+			f.Parent = iA;
+			a.Min = glm::min(b.Min, f.Min);
+			a.Max = glm::max(b.Max, f.Max);
+			c.Min = glm::min(a.Min, g.Min);
+			c.Max = glm::max(a.Max, g.Max);
+
+			a.Height = 1 + std::max(b.Height, f.Height);
+			c.Height = 1 + std::max(a.Height, g.Height);
+		}
+
+		return iC;
+	}
+
+	// Rotate B up
+	if (heightDifference < -1)
+	{
+		const auto iD{b.Left};
+		const auto iE{b.Right};
+		auto& d{nodes_[iD]};
+		auto& e{nodes_[iE]};
+
+		// Swap A and B
+		b.Left = iA;
+		b.Parent = a.Parent;
+		a.Parent = iB;
+
+		// A's old parent should point to B
+		if (b.Parent != -1)
+		{
+			if (nodes_[b.Parent].Left == iA)
+				nodes_[b.Parent].Left = iB;
+			else
+				nodes_[b.Parent].Right = iB;
+		}
+		else
+			root_ = iB;
+
+		// Move the taller of B's children up alongside A
+		if (d.Height > e.Height)
+		{
+			b.Right = iD;
+			a.Left = iE;
+			e.Parent = iA;
+			a.Min = glm::min(c.Min, e.Min);
+			a.Max = glm::max(c.Max, e.Max);
+			b.Min = glm::min(a.Min, d.Min);
+			b.Max = glm::max(a.Max, d.Max);
+
+			a.Height = 1 + std::max(c.Height, e.Height);
+			b.Height = 1 + std::max(a.Height, d.Height);
+		}
+		else
+		{
+			b.Right = iE;
+			a.Left = iD;
+			d.Parent = iA;
+			a.Min = glm::min(c.Min, d.Min);
+			a.Max = glm::max(c.Max, d.Max);
+			b.Min = glm::min(a.Min, e.Min);
+			b.Max = glm::max(a.Max, e.Max);
+
+			a.Height = 1 + std::max(c.Height, d.Height);
+			b.Height = 1 + std::max(a.Height, e.Height);
+		}
+
+		return iB;
+	}
+
+	return iA;
+}
+
+// Store the object's collision box on its leaf, expanded by the fat margin on every side
+void AabbTree::setFatBox(int leaf, const glm::vec3& position, const glm::vec3& size)
+{
+	nodes_[leaf].Min = position - fatMargin_;
+	nodes_[leaf].Max = position + size + fatMargin_;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "broadphase.h"
+#include <glm/vec3.hpp>
+#include <vector>
+
+// Class representing a dynamic bounding volume hierarchy over the collision boxes of GameObjects. Leaves store boxes fattened by a margin, so small movements (e.g., oscillating platforms) only cause a refit once an object leaves its fat box. The tree is kept balanced with rotations, giving logarithmic queries regardless of how objects are distributed. Implementation is based on the dynamic tree in Box2D by Erin Catto.
+class AabbTree : public Broadphase
+{
+public:
+	explicit AabbTree(float fatMargin);
+
+	void insert(GameObject& object) override;
+	void remove(GameObject& object) override;
+
+	// Refit the object's leaf, but only if its collision box has left the fat box it was inserted with
+	void update(int proxy, const glm::vec3& position, const glm::vec3& size) override;
+
+	// Get objects whose fat boxes overlap the given box
+	void query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const override;
+
+	// Get objects whose fat boxes overlap the given sphere
+	void querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const;
+
+	// Get objects whose fat boxes are intersected by the given ray within maxDistance. Direction need not be normalised, with maxDistance measured in multiples of its length
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const;
+
+	int getHeight() const;
+
+	// While deferred, update only flags leaves that have left their fat box, without modifying the tree. This allows objects to move concurrently. Disabling deferral refits all flagged leaves in proxy order, so the resulting tree doesn't depend on the order objects moved in
+	void setDeferUpdates(bool defer);
+
+private:
+	struct Node
+	{
+		glm::vec3 Min{};
+		glm::vec3 Max{};
+		GameObject* Object{};
+
+		// Doubles as the next free node when the node is unused
+		int Parent{-1};
+		int Left{-1};
+		int Right{-1};
+
+		// Leaves have a height of zero, unused nodes have a height of minus one
+		int Height{-1};
+
+		// Set on leaves needing a refit while updates are deferred
+		bool Moved{false};
+
+		bool isLeaf() const
+		{
+			return Left == -1;
+		}
+	};
+
+	float fatMargin_;
+	std::vector<Node> nodes_;
+	int root_;
+	int freeList_;
+	bool deferUpdates_;
+
+	int allocateNode();
+	void freeNode(int node);
+
+	void insertLeaf(int leaf);
+	void removeLeaf(int leaf);
+	int balance(int node);
+	void refit(int node);
+	void setFatBox(int leaf, const glm::vec3& position, const glm::vec3& size);
+
+	template<typename Overlaps>
+	void queryTree(const Overlaps& overlaps, std::vector<GameObject*>& results) const;
+};
@@ -0,0 +1,222 @@
+#include "assetmanager.h"
+#include "jobsystem.h"
+#include <chrono>
+#include <limits>
+#include <utility>
+
+AssetManager::AssetManager(GeometryManager& geometry) : geometry_{geometry}, jobs_{nullptr}, models_{}, hitCount_{0}, missCount_{0}, pending_{}, readyMutex_{}, readyCondition_{}, ready_{}, runningTasks_{0}
+{
+}
+
+// Models read but never uploaded are simply dropped, as there may be no OpenGL context left to upload them to
+AssetManager::~AssetManager()
+{
+	std::unique_lock<std::mutex> lock{readyMutex_};
+	readyCondition_.wait(lock, [this]() { return runningTasks_ == 0; });
+}
+
+void AssetManager::setJobSystem(JobSystem* jobs)
+{
+	jobs_ = jobs;
+}
+
+std::shared_ptr<const Model> AssetManager::getModel(const std::string& path, MeshRetention retention)
+{
+	// Loading the model again while it is being loaded in the background would upload it twice
+	if (pending_.find(path) != pending_.end())
+		finishLoading();
+
+	const auto found{models_.find(path)};
+	if (found != models_.end() && found->second->getRetention() >= retention)
+	{
+		++hitCount_;
+
+		return found->second;
+	}
+
+	++missCount_;
+
+	// The file is only loaded again if it has changed so much since the cached model was loaded that its meshes no longer match
+	if (found != models_.end() && found->second->retain(Model::readMeshes(path, retention)))
+		return found->second;
+
+	auto model{std::make_shared<Model>(path, geometry_, retention)};
+	models_[path] = model;
+
+	return model;
+}
+
+// The model is read by a worker, then queued for the main thread to upload, as only the main thread can create OpenGL objects
+std::shared_future<std::shared_ptr<const Model>> AssetManager::loadModelAsync(const std::string& path, MeshRetention retention)
+{
+	const auto found{models_.find(path)};
+	if (found != models_.end() && found->second->getRetention() >= retention)
+	{
+		++hitCount_;
+
+		std::promise<std::shared_ptr<const Model>> cached{};
+		cached.set_value(found->second);
+
+		return cached.get_future().share();
+	}
+
+	const auto loading{pending_.find(path)};
+	if (loading != pending_.end() && loading->second->Retention >= retention)
+	{
+		++hitCount_;
+
+		return loading->second->Future;
+	}
+
+	++missCount_;
+
+	auto pending{std::make_shared<PendingModel>()};
+	pending->Path = path;
+	pending->Retention = retention;
+	pending->Future = pending->Promise.get_future().share();
+	if (found != models_.end())
+		pending->Cached = found->second;
+	pending_[path] = pending;
+
+	runTask([this, pending]()
+	{
+		auto source{std::make_unique<Model::Source>(pending->Cached ? Model::readMeshes(pending->Path, pending->Retention) : Model::readSource(pending->Path, geometry_, pending->Retention, jobs_))};
+
+		std::lock_guard<std::mutex> lock{readyMutex_};
+		pending->Source = std::move(source);
+		ready_.push_back(pending);
+	});
+
+	return pending->Future;
+}
+
+std::shared_future<std::shared_ptr<const DecodedImage>> AssetManager::loadImageAsync(const std::string& path)
+{
+	auto promise{std::make_shared<std::promise<std::shared_ptr<const DecodedImage>>>()};
+	auto future{promise->get_future().share()};
+
+	runTask([path, promise]()
+	{
+		promise->set_value(std::make_shared<const DecodedImage>(decodeImage(path)));
+	});
+
+	return future;
+}
+
+// Checking the clock after each upload rather than estimating upload costs up front means a single large model can overrun the budget, but never more than one
+void AssetManager::processUploads(double budgetSeconds)
+{
+	const auto start{std::chrono::steady_clock::now()};
+
+	while (true)
+	{
+		std::shared_ptr<PendingModel> pending{};
+		{
+			std::lock_guard<std::mutex> lock{readyMutex_};
+			if (ready_.empty())
+				return;
+
+			pending = std::move(ready_.front());
+			ready_.pop_front();
+		}
+
+		upload(*pending);
+
+		if (std::chrono::duration<double>{std::chrono::steady_clock::now() - start}.count() >= budgetSeconds)
+			return;
+	}
+}
+
+// Every pending model's source is eventually queued, so waiting for the queue to fill can't block forever
+void AssetManager::finishLoading()
+{
+	while (!pending_.empty())
+	{
+		{
+			std::unique_lock<std::mutex> lock{readyMutex_};
+			readyCondition_.wait(lock, [this]() { return !ready_.empty(); });
+		}
+
+		processUploads(std::numeric_limits<double>::infinity());
+	}
+}
+
+// The cache holds one reference to each model, so a model with no other references is unused
+void AssetManager::releaseUnused()
+{
+	for (auto it{models_.begin()}; it != models_.end();)
+	{
+		if (it->second.use_count() == 1)
+			it = models_.erase(it);
+		else
+			++it;
+	}
+}
+
+int AssetManager::getModelCount() const
+{
+	return static_cast<int>(models_.size());
+}
+
+int AssetManager::getHitCount() const
+{
+	return hitCount_;
+}
+
+int AssetManager::getMissCount() const
+{
+	return missCount_;
+}
+
+int AssetManager::getPendingCount() const
+{
+	return static_cast<int>(pending_.size());
+}
+
+// The condition is notified while the lock is held, so the destructor can't see the task finish and destroy the condition before it is notified
+void AssetManager::runTask(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock{readyMutex_};
+		++runningTasks_;
+	}
+
+	auto run{[this, task{std::move(task)}]()
+	{
+		task();
+
+		std::lock_guard<std::mutex> lock{readyMutex_};
+		--runningTasks_;
+		readyCondition_.notify_all();
+	}};
+
+	if (jobs_)
+		jobs_->runInBackground(std::move(run));
+	else
+		run();
+}
+
+// A request for more retained data may have replaced this one while it was being read, in which case the replacement's result is kept in the cache. A cached model whose file no longer matches it can't be given more data, so the file is loaded again in full, there and then
+void AssetManager::upload(PendingModel& pending)
+{
+	std::shared_ptr<Model> model{};
+	if (!pending.Cached)
+		model = std::make_shared<Model>(std::move(*pending.Source), geometry_);
+	else if (pending.Cached->retain(*pending.Source))
+		model = std::move(pending.Cached);
+	else
+		model = std::make_shared<Model>(pending.Path, geometry_, pending.Retention);
+
+	pending.Source.reset();
+	pending.Cached.reset();
+
+	const auto cached{models_.find(pending.Path)};
+	if (cached == models_.end() || cached->second->getRetention() <= model->getRetention())
+		models_[pending.Path] = model;
+
+	const auto loading{pending_.find(pending.Path)};
+	if (loading != pending_.end() && loading->second.get() == &pending)
+		pending_.erase(loading);
+
+	pending.Promise.set_value(std::move(model));
+}
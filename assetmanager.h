@@ -0,0 +1,93 @@
+#pragma once
+
+#include "geometrymanager.h"
+#include "image.h"
+#include "model.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+class JobSystem;
+
+// Class loading models on request and caching them by path, so each file is loaded once however many objects use it. Models are handed out as shared, read-only handles, so objects hold a reference to the one copy of a model's meshes rather than copies of their own. Models can also be loaded in the background: worker threads read and process files and decode textures, and the results wait in a queue until the main thread uploads them, a few per frame within a time budget, so assets can be loaded while the game runs without stalling frames.
+class AssetManager
+{
+public:
+	// Models are uploaded to the given geometry buffers as they are loaded
+	explicit AssetManager(GeometryManager& geometry);
+
+	// Waits for loads still running in the background, as they refer to the manager
+	~AssetManager();
+
+	AssetManager(const AssetManager&) = delete;
+	AssetManager& operator=(const AssetManager&) = delete;
+
+	// Set the job system background loads run on. Without one, loads requested in the background are read immediately, on the calling thread
+	void setJobSystem(JobSystem* jobs);
+
+	// Get the model loaded from path, loading it if it isn't already cached. A cached model that kept less CPU-side mesh data than retention asks for is given the rest in place, by importing its file again without uploading anything, so every handle to the model sees the extra data. Waits for every background load if the model is one of them
+	std::shared_ptr<const Model> getModel(const std::string& path, MeshRetention retention = MeshRetention::NONE);
+
+	// Start loading the model at path in the background, or return the model if it is already cached or being loaded. The future becomes ready once processUploads has uploaded the model, so the main thread must poll it rather than wait on it, or call finishLoading first
+	std::shared_future<std::shared_ptr<const Model>> loadModelAsync(const std::string& path, MeshRetention retention = MeshRetention::NONE);
+
+	// Start decoding the image at path in the background. Images aren't cached, and need nothing from the main thread, so the future can be waited on from any thread
+	std::shared_future<std::shared_ptr<const DecodedImage>> loadImageAsync(const std::string& path);
+
+	// Upload models read in the background, stopping once budgetSeconds have passed. At least one model is uploaded if any are waiting, so loading always progresses. Call once per frame, on the thread owning the OpenGL context
+	void processUploads(double budgetSeconds);
+
+	// Upload every model requested in the background, waiting for any still being read. For loading screens and startup, where frames don't matter
+	void finishLoading();
+
+	// Drop cached models no longer used by anything outside the cache
+	void releaseUnused();
+
+	// Number of models in the cache, and requests served from and loaded into it
+	int getModelCount() const;
+	int getHitCount() const;
+	int getMissCount() const;
+
+	// Number of models requested in the background that haven't been uploaded yet
+	int getPendingCount() const;
+
+private:
+	// Model requested in the background. Source is filled in by the worker that reads it, then handed to the main thread through the ready queue
+	struct PendingModel
+	{
+		std::string Path{};
+		MeshRetention Retention{};
+		std::promise<std::shared_ptr<const Model>> Promise{};
+		std::shared_future<std::shared_ptr<const Model>> Future{};
+		std::unique_ptr<Model::Source> Source{};
+
+		// Cached model being given more CPU-side data, in which case Source holds only its meshes (see Model::readMeshes)
+		std::shared_ptr<Model> Cached{};
+	};
+
+	GeometryManager& geometry_;
+	JobSystem* jobs_;
+	std::unordered_map<std::string, std::shared_ptr<Model>> models_;
+	int hitCount_;
+	int missCount_;
+
+	// Models requested in the background, by path. Only used on the main thread
+	std::unordered_map<std::string, std::shared_ptr<PendingModel>> pending_;
+
+	// Models read and waiting for upload, and the number of background tasks still running, shared with workers
+	std::mutex readyMutex_;
+	std::condition_variable readyCondition_;
+	std::deque<std::shared_ptr<PendingModel>> ready_;
+	int runningTasks_;
+
+	// Run a task in the background, counting it as running until it finishes
+	void runTask(std::function<void()> task);
+
+	// Upload a model whose source has been read and hand it to everything waiting on it
+	void upload(PendingModel& pending);
+};
@@ -0,0 +1,300 @@
+#include "bakedmodel.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+	// File layout: a header, one record per mesh, then each mesh's level of detail ranges, texture records, texture strings, and vertex and index data. Records refer to everything after them by byte offset from the start of the file. Values are little-endian, as on every platform the game targets
+	constexpr char magic[4]{'B', 'B', 'M', 'D'};
+
+	// Vertex and index data start on this boundary, which suits copying them straight from the file
+	constexpr std::size_t dataAlignment{16};
+
+	struct FileHeader
+	{
+		char Magic[4];
+		std::uint32_t Version;
+		std::uint32_t MeshCount;
+		std::uint32_t Reserved;
+	};
+
+	struct MeshRecord
+	{
+		std::uint32_t Layout;
+		std::uint32_t ShortIndices;
+		std::uint32_t LodCount;
+		std::uint32_t TextureCount;
+		std::uint64_t VertexOffset;
+		std::uint64_t VertexBytes;
+		std::uint64_t IndexOffset;
+		std::uint64_t IndexBytes;
+		std::uint64_t LodOffset;
+		std::uint64_t TextureOffset;
+		float Min[3];
+		float Max[3];
+		float Centre[3];
+		float Radius;
+	};
+
+	struct LodRecord
+	{
+		std::uint32_t FirstIndex;
+		std::uint32_t IndexCount;
+	};
+
+	struct TextureRecord
+	{
+		std::uint64_t TypeOffset;
+		std::uint64_t PathOffset;
+		std::uint32_t TypeLength;
+		std::uint32_t PathLength;
+	};
+
+	// Records are copied to and from the file as they are, so must have no padding that could differ between compilers
+	static_assert(sizeof(FileHeader) == 16, "Unexpected padding in FileHeader");
+	static_assert(sizeof(MeshRecord) == 104, "Unexpected padding in MeshRecord");
+	static_assert(sizeof(LodRecord) == 8, "Unexpected padding in LodRecord");
+	static_assert(sizeof(TextureRecord) == 24, "Unexpected padding in TextureRecord");
+
+	// Whether size bytes from offset lie within a file of fileSize bytes, written so it can't overflow
+	bool inFile(std::uint64_t offset, std::uint64_t size, std::size_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset;
+	}
+
+	// Records are read by copying, as nothing guarantees they are aligned within the mapping
+	template <typename Record>
+	Record readRecord(const unsigned char* data, std::uint64_t offset)
+	{
+		Record record{};
+		std::memcpy(&record, data + offset, sizeof(Record));
+
+		return record;
+	}
+
+	// Whether each of count indices starting at data addresses one of vertexCount vertices. Indices are copied out one at a time, as a malformed file may not align them
+	template <typename Index>
+	bool areIndicesInRange(const unsigned char* data, std::uint64_t count, std::uint64_t vertexCount)
+	{
+		for (std::uint64_t i{0}; i < count; ++i)
+		{
+			Index index{};
+			std::memcpy(&index, data + i * sizeof(Index), sizeof(Index));
+			if (index >= vertexCount)
+				return false;
+		}
+
+		return true;
+	}
+
+	template <typename Record>
+	void writeRecord(std::vector<unsigned char>& file, std::size_t offset, const Record& record)
+	{
+		std::memcpy(file.data() + offset, &record, sizeof(Record));
+	}
+
+	// Append bytes to the file, returning where they start. Without data, the bytes are zeroed for filling in later
+	std::uint64_t append(std::vector<unsigned char>& file, const void* data, std::size_t size, std::size_t alignment = 1)
+	{
+		file.resize((file.size() + alignment - 1) / alignment * alignment);
+
+		const auto offset{file.size()};
+		file.resize(offset + size);
+		if (data && size > 0)
+			std::memcpy(file.data() + offset, data, size);
+
+		return offset;
+	}
+}
+
+BakedModel::BakedModel(const std::string& path) : file_{path}, meshes_{}, valid_{false}
+{
+	if (!file_.isOpen())
+		return;
+
+	valid_ = read();
+	if (!valid_)
+	{
+		std::cout << "ERROR::BAKED_MODEL::INVALID_FILE: " << path << "\n";
+
+		meshes_.clear();
+		file_.close();
+	}
+}
+
+// Check every offset and size against the file before using it, and every index against the mesh's vertices, so a truncated or corrupt file is rejected rather than read, or drawn, out of bounds
+bool BakedModel::read()
+{
+	const auto data{file_.getData()};
+	const auto size{file_.getSize()};
+
+	if (!inFile(0, sizeof(FileHeader), size))
+		return false;
+
+	const auto header{readRecord<FileHeader>(data, 0)};
+	if (std::memcmp(header.Magic, magic, sizeof(magic)) != 0 || header.Version != Version)
+		return false;
+
+	if (!inFile(sizeof(FileHeader), static_cast<std::uint64_t>(header.MeshCount) * sizeof(MeshRecord), size))
+		return false;
+
+	for (std::uint32_t i{0}; i < header.MeshCount; ++i)
+	{
+		const auto record{readRecord<MeshRecord>(data, sizeof(FileHeader) + static_cast<std::uint64_t>(i) * sizeof(MeshRecord))};
+
+		if (record.Layout > static_cast<std::uint32_t>(VertexLayout::PACKED_TANGENTS) || record.LodCount == 0)
+			return false;
+
+		auto mesh{BakedMesh{}};
+		auto& geometry{mesh.Geometry};
+		geometry.Layout = static_cast<VertexLayout>(record.Layout);
+		geometry.ShortIndices = record.ShortIndices != 0;
+
+		// Ranges must hold whole vertices and indices, as the geometry manager relies on it to keep its buffers aligned
+		const auto indexSize{geometry.ShortIndices ? sizeof(std::uint16_t) : sizeof(std::uint32_t)};
+		if (!inFile(record.VertexOffset, record.VertexBytes, size) || record.VertexBytes % GeometryManager::getVertexStride(geometry.Layout) != 0)
+			return false;
+		if (!inFile(record.IndexOffset, record.IndexBytes, size) || record.IndexBytes % indexSize != 0)
+			return false;
+
+		const auto vertexCount{record.VertexBytes / GeometryManager::getVertexStride(geometry.Layout)};
+		if (geometry.ShortIndices && vertexCount > GeometryManager::MaxShortIndexVertices)
+			return false;
+
+		geometry.VertexData = data + record.VertexOffset;
+		geometry.VertexBytes = static_cast<long long>(record.VertexBytes);
+		geometry.IndexData = data + record.IndexOffset;
+		geometry.IndexBytes = static_cast<long long>(record.IndexBytes);
+
+		if (!inFile(record.LodOffset, static_cast<std::uint64_t>(record.LodCount) * sizeof(LodRecord), size))
+			return false;
+
+		const auto indexCount{record.IndexBytes / indexSize};
+		// Indices past the mesh's vertices would have the GPU read other meshes' vertices, or past the end of the buffer
+		const auto indices{data + record.IndexOffset};
+		if (geometry.ShortIndices ? !areIndicesInRange<std::uint16_t>(indices, indexCount, vertexCount) : !areIndicesInRange<std::uint32_t>(indices, indexCount, vertexCount))
+			return false;
+
+		for (std::uint32_t lod{0}; lod < record.LodCount; ++lod)
+		{
+			const auto range{readRecord<LodRecord>(data, record.LodOffset + static_cast<std::uint64_t>(lod) * sizeof(LodRecord))};
+			if (static_cast<std::uint64_t>(range.FirstIndex) + range.IndexCount > indexCount)
+				return false;
+
+			geometry.Lods.push_back(IndexRange{static_cast<int>(range.FirstIndex), static_cast<int>(range.IndexCount)});
+		}
+
+		if (!inFile(record.TextureOffset, static_cast<std::uint64_t>(record.TextureCount) * sizeof(TextureRecord), size))
+			return false;
+
+		for (std::uint32_t i{0}; i < record.TextureCount; ++i)
+		{
+			const auto reference{readRecord<TextureRecord>(data, record.TextureOffset + static_cast<std::uint64_t>(i) * sizeof(TextureRecord))};
+			if (!inFile(reference.TypeOffset, reference.TypeLength, size) || !inFile(reference.PathOffset, reference.PathLength, size))
+				return false;
+
+			auto texture{Texture{}};
+			texture.Type.assign(reinterpret_cast<const char*>(data + reference.TypeOffset), reference.TypeLength);
+			texture.Path.assign(reinterpret_cast<const char*>(data + reference.PathOffset), reference.PathLength);
+			mesh.Textures.push_back(std::move(texture));
+		}
+
+		mesh.Bounds.Min = glm::vec3{record.Min[0], record.Min[1], record.Min[2]};
+		mesh.Bounds.Max = glm::vec3{record.Max[0], record.Max[1], record.Max[2]};
+		mesh.Bounds.Centre = glm::vec3{record.Centre[0], record.Centre[1], record.Centre[2]};
+		mesh.Bounds.Radius = record.Radius;
+
+		meshes_.push_back(std::move(mesh));
+	}
+
+	return true;
+}
+
+void BakedModelWriter::addMesh(const PackedGeometry& geometry, const BoundingVolume& bounds, const std::vector<Texture>& textures)
+{
+	const auto vertices{static_cast<const unsigned char*>(geometry.VertexData)};
+	const auto indices{static_cast<const unsigned char*>(geometry.IndexData)};
+
+	auto entry{MeshEntry{}};
+	entry.Layout = geometry.Layout;
+	entry.ShortIndices = geometry.ShortIndices;
+	entry.Vertices.assign(vertices, vertices + geometry.VertexBytes);
+	entry.Indices.assign(indices, indices + geometry.IndexBytes);
+	entry.Lods = geometry.Lods;
+	entry.Bounds = bounds;
+	entry.Textures = textures;
+
+	meshes_.push_back(std::move(entry));
+}
+
+// Build the whole file in memory, leaving room for the mesh records and filling them in once everything they refer to has been placed
+bool BakedModelWriter::write(const std::string& path) const
+{
+	std::vector<unsigned char> file(sizeof(FileHeader) + meshes_.size() * sizeof(MeshRecord));
+
+	auto header{FileHeader{}};
+	std::memcpy(header.Magic, magic, sizeof(magic));
+	header.Version = BakedModel::Version;
+	header.MeshCount = static_cast<std::uint32_t>(meshes_.size());
+	writeRecord(file, 0, header);
+
+	for (std::size_t i{0}; i < meshes_.size(); ++i)
+	{
+		const auto& mesh{meshes_[i]};
+
+		auto record{MeshRecord{}};
+		record.Layout = static_cast<std::uint32_t>(mesh.Layout);
+		record.ShortIndices = mesh.ShortIndices ? 1 : 0;
+		record.LodCount = static_cast<std::uint32_t>(mesh.Lods.size());
+		record.TextureCount = static_cast<std::uint32_t>(mesh.Textures.size());
+
+		record.LodOffset = file.size();
+		for (const auto& lod : mesh.Lods)
+		{
+			const auto range{LodRecord{static_cast<std::uint32_t>(lod.FirstIndex), static_cast<std::uint32_t>(lod.IndexCount)}};
+			append(file, &range, sizeof(range));
+		}
+
+		// Texture records are placed before their strings, so are filled in once the strings have been appended
+		record.TextureOffset = append(file, nullptr, mesh.Textures.size() * sizeof(TextureRecord));
+		for (std::size_t texture{0}; texture < mesh.Textures.size(); ++texture)
+		{
+			const auto& reference{mesh.Textures[texture]};
+
+			auto textureRecord{TextureRecord{}};
+			textureRecord.TypeLength = static_cast<std::uint32_t>(reference.Type.size());
+			textureRecord.PathLength = static_cast<std::uint32_t>(reference.Path.size());
+			textureRecord.TypeOffset = append(file, reference.Type.data(), reference.Type.size());
+			textureRecord.PathOffset = append(file, reference.Path.data(), reference.Path.size());
+			writeRecord(file, record.TextureOffset + texture * sizeof(TextureRecord), textureRecord);
+		}
+
+		record.VertexBytes = mesh.Vertices.size();
+		record.VertexOffset = append(file, mesh.Vertices.data(), mesh.Vertices.size(), dataAlignment);
+		record.IndexBytes = mesh.Indices.size();
+		record.IndexOffset = append(file, mesh.Indices.data(), mesh.Indices.size(), dataAlignment);
+
+		for (auto axis{0}; axis < 3; ++axis)
+		{
+			record.Min[axis] = mesh.Bounds.Min[axis];
+			record.Max[axis] = mesh.Bounds.Max[axis];
+			record.Centre[axis] = mesh.Bounds.Centre[axis];
+		}
+		record.Radius = mesh.Bounds.Radius;
+
+		writeRecord(file, sizeof(FileHeader) + i * sizeof(MeshRecord), record);
+	}
+
+	std::ofstream stream{path, std::ios::binary | std::ios::trunc};
+	stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+	if (!stream)
+	{
+		std::cout << "ERROR::BAKED_MODEL::WRITE_FAILED: " << path << "\n";
+
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "geometrymanager.h"
+#include "mappedfile.h"
+#include "mesh.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Mesh read from a baked model file, with its geometry pointing into the mapped file. Textures are references only, with no ids, as the file names them rather than holding them
+struct BakedMesh
+{
+	PackedGeometry Geometry{};
+	BoundingVolume Bounds{};
+	std::vector<Texture> Textures{};
+};
+
+// Class reading a baked model file: meshes already optimised, simplified into levels of detail, and packed into the layout they are stored in on the GPU, so loading is a matter of mapping the file and uploading straight from it. The file stays mapped for the lifetime of the object, so its meshes must be uploaded before it is destroyed.
+class BakedModel
+{
+public:
+	// Map and validate the file at path. The model is invalid if the file is missing, was baked by another version, or is malformed
+	explicit BakedModel(const std::string& path);
+
+	bool isValid() const
+	{
+		return valid_;
+	}
+
+	const std::vector<BakedMesh>& getMeshes() const
+	{
+		return meshes_;
+	}
+
+	// Version of the file format and of the processing baked into it. Increase whenever either changes, e.g., packed vertex layouts or level of detail generation, so stale files are rebaked rather than misread
+	static constexpr std::uint32_t Version{1};
+
+private:
+	MappedFile file_;
+	std::vector<BakedMesh> meshes_;
+	bool valid_;
+
+	bool read();
+};
+
+// Class collecting packed meshes and writing them to a baked model file, see BakedModel
+class BakedModelWriter
+{
+public:
+	// Copy a packed mesh, which may point into scratch storage, and the types and paths of its material's textures into the file being built
+	void addMesh(const PackedGeometry& geometry, const BoundingVolume& bounds, const std::vector<Texture>& textures);
+
+	// Write every mesh added to a file at path, returning whether it was written successfully
+	bool write(const std::string& path) const;
+
+private:
+	struct MeshEntry
+	{
+		VertexLayout Layout{};
+		bool ShortIndices{};
+		std::vector<unsigned char> Vertices{};
+		std::vector<unsigned char> Indices{};
+		std::vector<IndexRange> Lods{};
+		BoundingVolume Bounds{};
+		std::vector<Texture> Textures{};
+	};
+
+	std::vector<MeshEntry> meshes_;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <algorithm>
+
+// Overlap tests between axis-aligned boxes (given by their minimum and maximum corners) and query shapes, shared by the collision acceleration structures
+
+inline bool overlapsBox(const glm::vec3& min, const glm::vec3& max, const glm::vec3& queryMin, const glm::vec3& queryMax)
+{
+	return min.x <= queryMax.x && max.x >= queryMin.x &&
+		min.y <= queryMax.y && max.y >= queryMin.y &&
+		min.z <= queryMax.z && max.z >= queryMin.z;
+}
+
+inline bool overlapsSphere(const glm::vec3& min, const glm::vec3& max, const glm::vec3& centre, float radiusSquared)
+{
+	// Distance from the sphere's centre to the closest point on the box
+	const auto offset{centre - glm::clamp(centre, min, max)};
+
+	return glm::dot(offset, offset) <= radiusSquared;
+}
+
+// Slab test -- find the interval along the ray inside each pair of box faces and check the intervals overlap. Division by zero in inverseDirection produces infinities, which the test handles correctly
+inline bool overlapsRay(const glm::vec3& min, const glm::vec3& max, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance)
+{
+	const auto t1{(min - origin) * inverseDirection};
+	const auto t2{(max - origin) * inverseDirection};
+	const auto tMin{glm::min(t1, t2)};
+	const auto tMax{glm::max(t1, t2)};
+
+	const auto entry{std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f))};
+	const auto exit{std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance))};
+
+	return entry <= exit;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+
+class GameObject;
+
+// Interface for spatial structures that track the collision boxes of GameObjects to cheaply find objects near a region. Registered objects notify their broadphase whenever their collision box changes.
+class Broadphase
+{
+public:
+	virtual ~Broadphase() = default;
+
+	// Register an object using its current collision box
+	virtual void insert(GameObject& object) = 0;
+
+	// Stop tracking an object
+	virtual void remove(GameObject& object) = 0;
+
+	// Respond to a registered object's collision box changing
+	virtual void update(int proxy, const glm::vec3& position, const glm::vec3& size) = 0;
+
+	// Get objects whose collision boxes may overlap the given box
+	virtual void query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const = 0;
+};
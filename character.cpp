@@ -2,7 +2,13 @@
 #include "gameobject.h"
 #include "glm/gtc/matrix_transform.hpp"
 
-Character::Character(const glm::vec3& pos, const glm::vec3& siz, float radius) : GameObject{pos, siz}, Front{glm::vec3{0.0f, 0.0f, -1.0f}}, Forward{glm::vec3{0.0f, 0.0f, -1.0f}}, Up{glm::vec3{0.0f, 1.0f, 0.0f}}, Right{}, WorldUp{Up}, Yaw{-90.0f}, Pitch{0.0f}, MovementSpeed{0.035f}, MouseSensitivity{0.1f}, Fov{85.0f}, Radius{radius}, Grounded{false}
+namespace
+{
+	// Upward velocity added on the first tick of a jump
+	constexpr auto startingJumpVel{0.25f};
+}
+
+Character::Character(const glm::vec3& pos, const glm::vec3& siz, float radius) : GameObject{pos, siz}, Front{glm::vec3{0.0f, 0.0f, -1.0f}}, Forward{glm::vec3{0.0f, 0.0f, -1.0f}}, Up{glm::vec3{0.0f, 1.0f, 0.0f}}, Right{}, WorldUp{Up}, Yaw{-90.0f}, Pitch{0.0f}, MovementSpeed{0.035f}, MouseSensitivity{0.1f}, Fov{85.0f}, Radius{radius}, Grounded{false}, Jumping{false}, JumpPressed{false}, JumpCount{0}, JumpVelocity{startingJumpVel}
 {
 	updateDirectionVectors();
 }
@@ -20,49 +26,42 @@ void Character::processKeyboard(PlayerMovement direction)
 	if (direction == PlayerMovement::LEFT)
 		addVelocity(-Right * MovementSpeed);
 
-	// Values for jumping logic
-	constexpr auto startingJumpVel{0.25f};
-	static auto jumping{false};
-	static auto jumpPressed{false};
-	static auto jumpCount{0};
-	static auto jumpVel{startingJumpVel};
-
-	if (direction == PlayerMovement::JUMP_PRESSED && Grounded && !jumpPressed)
+	if (direction == PlayerMovement::JUMP_PRESSED && Grounded && !JumpPressed)
 	{
-		jumping = true;
+		Jumping = true;
 
 		Grounded = false;
 
-		jumpPressed = true;
+		JumpPressed = true;
 	}
 
 	// If jump button is released at this point, it won't take affect until the next iteration
 	if (direction == PlayerMovement::JUMP_RELEASED)
 	{
-		jumpPressed = false;
+		JumpPressed = false;
 	}
 
 	// Climb until velocity is lost
-	if (jumping)
+	if (Jumping)
 	{
-		addVelocity(WorldUp * jumpVel);
-		++jumpCount;
-		jumpVel *= 0.95f;
+		addVelocity(WorldUp * JumpVelocity);
+		++JumpCount;
+		JumpVelocity *= 0.95f;
 
-		if (jumpCount >= 180)
+		if (JumpCount >= 180)
 		{
-			jumping = false;
-			jumpCount = 0;
-			jumpVel = startingJumpVel;
+			Jumping = false;
+			JumpCount = 0;
+			JumpVelocity = startingJumpVel;
 		}
 	}
 
 	// If land early, reset jumping state
 	if (Grounded)
 	{
-		jumping = false;
-		jumpCount = 0;
-		jumpVel = startingJumpVel;
+		Jumping = false;
+		JumpCount = 0;
+		JumpVelocity = startingJumpVel;
 	}
 }
 
@@ -93,7 +92,6 @@ glm::mat4 Character::getViewMatrix() const
 
 void Character::tick(float deltaTime)
 {
-	move();
 }
 
 // Update direction vectors for the camera view and player character movement
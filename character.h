@@ -68,6 +68,7 @@ public:
 		Grounded = grounded;
 	}
 
+	// Characters are only moved by Game::moveAndSlide, which sweeps them through the world so they can't tunnel, so ticking leaves their velocity for it rather than moving them as other objects do
 	virtual void tick(float deltaTime) override;
 
 private:
@@ -87,6 +88,12 @@ private:
 
 	bool Grounded;
 
+	// Jumping state
+	bool Jumping;
+	bool JumpPressed;
+	int JumpCount;
+	float JumpVelocity;
+
 	// Calculates the front vector from the camera's current Euler Angles
 	void updateDirectionVectors();
 };
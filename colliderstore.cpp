@@ -0,0 +1,147 @@
+#include "colliderstore.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COLLIDERSTORE_SSE2
+#endif
+
+ColliderStore::ColliderStore() : centreX_{}, centreY_{}, centreZ_{}, halfExtentX_{}, halfExtentY_{}, halfExtentZ_{}
+{
+}
+
+void ColliderStore::clear()
+{
+	centreX_.clear();
+	centreY_.clear();
+	centreZ_.clear();
+	halfExtentX_.clear();
+	halfExtentY_.clear();
+	halfExtentZ_.clear();
+}
+
+// Store the box's centre and half-extents, calculated the same way as in checkSphereBox
+int ColliderStore::add(const glm::vec3& position, const glm::vec3& size)
+{
+	const auto halfExtents{glm::vec3{size.x / 2.0f, size.y / 2.0f, size.z / 2.0f}};
+
+	centreX_.push_back(position.x + halfExtents.x);
+	centreY_.push_back(position.y + halfExtents.y);
+	centreZ_.push_back(position.z + halfExtents.z);
+	halfExtentX_.push_back(halfExtents.x);
+	halfExtentY_.push_back(halfExtents.y);
+	halfExtentZ_.push_back(halfExtents.z);
+
+	return static_cast<int>(centreX_.size()) - 1;
+}
+
+// Find the closest point on each box to the sphere's centre and check if it lies within the sphere's radius. Boxes left over after the last full SIMD batch are tested one at a time
+void ColliderStore::testSphere(const glm::vec3& centre, float radius, std::vector<int>& hits) const
+{
+	const auto count{size()};
+	auto i{0};
+
+#if defined(__AVX2__)
+	const auto cx{_mm256_set1_ps(centre.x)};
+	const auto cy{_mm256_set1_ps(centre.y)};
+	const auto cz{_mm256_set1_ps(centre.z)};
+	const auto r{_mm256_set1_ps(radius)};
+	const auto signMask{_mm256_set1_ps(-0.0f)};
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const auto bx{_mm256_loadu_ps(&centreX_[i])};
+		const auto by{_mm256_loadu_ps(&centreY_[i])};
+		const auto bz{_mm256_loadu_ps(&centreZ_[i])};
+		const auto hx{_mm256_loadu_ps(&halfExtentX_[i])};
+		const auto hy{_mm256_loadu_ps(&halfExtentY_[i])};
+		const auto hz{_mm256_loadu_ps(&halfExtentZ_[i])};
+
+		// Clamp difference between centres to the half-extents
+		const auto clampedX{_mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(cx, bx), _mm256_xor_ps(hx, signMask)), hx)};
+		const auto clampedY{_mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(cy, by), _mm256_xor_ps(hy, signMask)), hy)};
+		const auto clampedZ{_mm256_min_ps(_mm256_max_ps(_mm256_sub_ps(cz, bz), _mm256_xor_ps(hz, signMask)), hz)};
+
+		// Vector from sphere centre to closest point on the box
+		const auto lx{_mm256_sub_ps(_mm256_add_ps(bx, clampedX), cx)};
+		const auto ly{_mm256_sub_ps(_mm256_add_ps(by, clampedY), cy)};
+		const auto lz{_mm256_sub_ps(_mm256_add_ps(bz, clampedZ), cz)};
+
+		const auto lengthSquared{_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz))};
+		const auto hit{_mm256_cmp_ps(_mm256_sqrt_ps(lengthSquared), r, _CMP_LT_OQ)};
+
+		const auto mask{_mm256_movemask_ps(hit)};
+		for (auto lane{0}; mask && lane < 8; ++lane)
+		{
+			if (mask & (1 << lane))
+				hits.push_back(i + lane);
+		}
+	}
+#elif defined(COLLIDERSTORE_SSE2)
+	const auto cx{_mm_set1_ps(centre.x)};
+	const auto cy{_mm_set1_ps(centre.y)};
+	const auto cz{_mm_set1_ps(centre.z)};
+	const auto r{_mm_set1_ps(radius)};
+	const auto signMask{_mm_set1_ps(-0.0f)};
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const auto bx{_mm_loadu_ps(&centreX_[i])};
+		const auto by{_mm_loadu_ps(&centreY_[i])};
+		const auto bz{_mm_loadu_ps(&centreZ_[i])};
+		const auto hx{_mm_loadu_ps(&halfExtentX_[i])};
+		const auto hy{_mm_loadu_ps(&halfExtentY_[i])};
+		const auto hz{_mm_loadu_ps(&halfExtentZ_[i])};
+
+		// Clamp difference between centres to the half-extents
+		const auto clampedX{_mm_min_ps(_mm_max_ps(_mm_sub_ps(cx, bx), _mm_xor_ps(hx, signMask)), hx)};
+		const auto clampedY{_mm_min_ps(_mm_max_ps(_mm_sub_ps(cy, by), _mm_xor_ps(hy, signMask)), hy)};
+		const auto clampedZ{_mm_min_ps(_mm_max_ps(_mm_sub_ps(cz, bz), _mm_xor_ps(hz, signMask)), hz)};
+
+		// Vector from sphere centre to closest point on the box
+		const auto lx{_mm_sub_ps(_mm_add_ps(bx, clampedX), cx)};
+		const auto ly{_mm_sub_ps(_mm_add_ps(by, clampedY), cy)};
+		const auto lz{_mm_sub_ps(_mm_add_ps(bz, clampedZ), cz)};
+
+		const auto lengthSquared{_mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz))};
+		const auto hit{_mm_cmplt_ps(_mm_sqrt_ps(lengthSquared), r)};
+
+		const auto mask{_mm_movemask_ps(hit)};
+		for (auto lane{0}; mask && lane < 4; ++lane)
+		{
+			if (mask & (1 << lane))
+				hits.push_back(i + lane);
+		}
+	}
+#endif
+
+	testSphereScalar(centre, radius, i, hits);
+}
+
+void ColliderStore::testSphereScalar(const glm::vec3& centre, float radius, std::vector<int>& hits) const
+{
+	testSphereScalar(centre, radius, 0, hits);
+}
+
+// Test boxes from the given index onwards one at a time, mirroring the operations of the SIMD paths
+void ColliderStore::testSphereScalar(const glm::vec3& centre, float radius, int first, std::vector<int>& hits) const
+{
+	const auto count{size()};
+
+	for (auto i{first}; i < count; ++i)
+	{
+		const auto clampedX{std::min(std::max(centre.x - centreX_[i], -halfExtentX_[i]), halfExtentX_[i])};
+		const auto clampedY{std::min(std::max(centre.y - centreY_[i], -halfExtentY_[i]), halfExtentY_[i])};
+		const auto clampedZ{std::min(std::max(centre.z - centreZ_[i], -halfExtentZ_[i]), halfExtentZ_[i])};
+
+		const auto lx{(centreX_[i] + clampedX) - centre.x};
+		const auto ly{(centreY_[i] + clampedY) - centre.y};
+		const auto lz{(centreZ_[i] + clampedZ) - centre.z};
+
+		if (std::sqrt(lx * lx + ly * ly + lz * lz) < radius)
+			hits.push_back(i);
+	}
+}
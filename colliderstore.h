@@ -0,0 +1,38 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+
+// Class storing axis-aligned collision boxes as a structure of arrays (separate centre and half-extent arrays per axis), so a sphere can be tested against several boxes at once using SIMD instructions. Results match checkSphereBox exactly, as the same floating point operations are performed in the same order.
+class ColliderStore
+{
+public:
+	ColliderStore();
+
+	// Remove all boxes, keeping allocated memory for reuse
+	void clear();
+
+	// Add a box from a GameObject position (its minimum corner) and size. Returns the index of the box
+	int add(const glm::vec3& position, const glm::vec3& size);
+
+	int size() const
+	{
+		return static_cast<int>(centreX_.size());
+	}
+
+	// Append the indices of all boxes overlapping the sphere to hits, in ascending order. Uses AVX2 (8 boxes per instruction) or SSE (4 boxes per instruction) where available
+	void testSphere(const glm::vec3& centre, float radius, std::vector<int>& hits) const;
+
+	// Reference implementation of testSphere, one box at a time
+	void testSphereScalar(const glm::vec3& centre, float radius, std::vector<int>& hits) const;
+
+private:
+	std::vector<float> centreX_;
+	std::vector<float> centreY_;
+	std::vector<float> centreZ_;
+	std::vector<float> halfExtentX_;
+	std::vector<float> halfExtentY_;
+	std::vector<float> halfExtentZ_;
+
+	void testSphereScalar(const glm::vec3& centre, float radius, int first, std::vector<int>& hits) const;
+};
@@ -0,0 +1,75 @@
+#include "collision.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+// Check for collision between an AABB and a sphere. ColliderStore mirrors these operations exactly, so any change here must be made there too
+Collision checkSphereBox(const glm::vec3& centre, float radius, const glm::vec3& boxPosition, const glm::vec3& boxSize)
+{
+	// Find ABB centre and half-extents
+	const auto aabbHalfExtents
+	{
+		glm::vec3
+		{
+			boxSize.x / 2.0f,
+			boxSize.y / 2.0f,
+			boxSize.z / 2.0f
+		}
+	};
+	const auto aabbCentre
+	{
+		glm::vec3
+		{
+			boxPosition.x + aabbHalfExtents.x,
+			boxPosition.y + aabbHalfExtents.y,
+			boxPosition.z + aabbHalfExtents.z
+		}
+	};
+
+	// Find difference between both centres
+	const auto difference{centre - aabbCentre};
+	const auto clampedDiff{glm::clamp(difference, -aabbHalfExtents, aabbHalfExtents)};
+
+	// Find position closest to the sphere
+	const auto closestPoint{aabbCentre + clampedDiff};
+
+	// Get vector between sphere's centre and closest AABB point, and check if length is less than the sphere's radius
+	const auto length{closestPoint - centre};
+
+	// If collision...
+	if (glm::length(length) < radius)
+		return std::make_tuple(true, getVectorDirection(length), length);
+
+	return std::make_tuple(false, Direction::X_POS, glm::vec3{0.0f});
+}
+
+// Get the direction the player is a colliding with an object from
+Direction getVectorDirection(const glm::vec3& target)
+{
+	constexpr glm::vec3 directions[]
+	{
+		glm::vec3{1.0f, 0.0f, 0.0f}, // Positive X
+		glm::vec3{-1.0f, 0.0f, 0.0f}, // Negative X
+		glm::vec3{0.0f, 1.0f, 0.0f}, // Positive Y
+		glm::vec3{0.0f, -1.0f, 0.0f}, // Negative Y
+		glm::vec3{0.0f, 0.0f, 1.0f}, // Positive Z
+		glm::vec3{0.0f, 0.0f, -1.0f} // Negative Z
+	};
+
+	auto max{0.0f};
+
+	auto bestMatch{-1};
+
+	for (auto i{0}; i < 6; ++i)
+	{
+		const auto dotProduct{glm::dot(glm::normalize(target), directions[i])};
+
+		if (dotProduct > max)
+		{
+			max = dotProduct;
+
+			bestMatch = i;
+		}
+	}
+
+	return static_cast<Direction>(bestMatch);
+}
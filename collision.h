@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <tuple>
+
+enum class Direction
+{
+	X_POS,
+	X_NEG,
+	Y_POS,
+	Y_NEG,
+	Z_POS,
+	Z_NEG
+};
+
+// Type to contain data about collisions between the player and other objects
+using Collision = std::tuple<bool, Direction, glm::vec3>;
+
+// Check for collision between a sphere and an axis-aligned box given by its position (minimum corner) and size, as used for characters and GameObjects
+Collision checkSphereBox(const glm::vec3& centre, float radius, const glm::vec3& boxPosition, const glm::vec3& boxSize);
+
+// Get the side of a box a collision vector points into
+Direction getVectorDirection(const glm::vec3& target);
@@ -0,0 +1,142 @@
+#include "collisionworld.h"
+#include "bounds.h"
+#include "gameobject.h"
+#include "sweep.h"
+#include <glm/common.hpp>
+
+namespace
+{
+	// Reusable storage for candidates found during scene queries, one per thread so queries can run concurrently
+	std::vector<GameObject*>& getCandidateScratch()
+	{
+		thread_local std::vector<GameObject*> candidates{};
+		candidates.clear();
+
+		return candidates;
+	}
+}
+
+CollisionWorld::CollisionWorld(float fatMargin) : staticTree_{}, dynamicTree_{fatMargin}, pendingStatic_{}, dynamicCount_{0}
+{
+}
+
+void CollisionWorld::add(GameObject& object)
+{
+	if (object.isStatic())
+	{
+		pendingStatic_.push_back(&object);
+	}
+	else
+	{
+		dynamicTree_.insert(object);
+		++dynamicCount_;
+	}
+}
+
+void CollisionWorld::buildStatic()
+{
+	staticTree_.build(pendingStatic_);
+}
+
+void CollisionWorld::setDeferUpdates(bool defer)
+{
+	dynamicTree_.setDeferUpdates(defer);
+}
+
+void CollisionWorld::query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const
+{
+	staticTree_.query(min, max, results);
+	dynamicTree_.query(min, max, results);
+}
+
+void CollisionWorld::querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const
+{
+	staticTree_.querySphere(centre, radius, results);
+	dynamicTree_.querySphere(centre, radius, results);
+}
+
+void CollisionWorld::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const
+{
+	staticTree_.queryRay(origin, direction, maxDistance, results);
+	dynamicTree_.queryRay(origin, direction, maxDistance, results);
+}
+
+// A ray is a sphere of zero radius, so cast one of those
+CastHit CollisionWorld::raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	return sphereCast(origin, 0.0f, direction, maxDistance);
+}
+
+// Sweep the sphere against every candidate overlapping the volume it moves through, keeping the earliest hit
+CastHit CollisionWorld::sphereCast(const glm::vec3& centre, float radius, const glm::vec3& direction, float maxDistance) const
+{
+	CastHit result{};
+
+	const auto displacement{direction * maxDistance};
+	auto& candidates{getCandidateScratch()};
+	if (radius > 0.0f)
+		query(glm::min(centre, centre + displacement) - radius, glm::max(centre, centre + displacement) + radius, candidates);
+	else
+		queryRay(centre, direction, maxDistance, candidates);
+
+	SweepHit closest{};
+	for (const auto obj : candidates)
+	{
+		const auto& objectPos{obj->getPosition()};
+		const auto hit{sweepSphereAabb(centre, displacement, radius, objectPos, objectPos + obj->getSize())};
+
+		if (hit.Hit && (!closest.Hit || hit.Time < closest.Time))
+		{
+			closest = hit;
+			result.Object = obj;
+		}
+	}
+
+	if (closest.Hit)
+	{
+		result.Hit = true;
+		result.Distance = closest.Time * maxDistance;
+		result.Position = centre + displacement * closest.Time;
+		result.Normal = closest.Normal;
+	}
+
+	return result;
+}
+
+bool CollisionWorld::hasLineOfSight(const glm::vec3& from, const glm::vec3& to) const
+{
+	const auto offset{to - from};
+	const auto distance{length(offset)};
+
+	if (distance == 0.0f)
+		return true;
+
+	return !raycast(from, offset / distance, distance).Hit;
+}
+
+void CollisionWorld::overlapSphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const
+{
+	auto& candidates{getCandidateScratch()};
+	querySphere(centre, radius, candidates);
+
+	const auto radiusSquared{radius * radius};
+	for (const auto obj : candidates)
+	{
+		const auto& objectPos{obj->getPosition()};
+		if (overlapsSphere(objectPos, objectPos + obj->getSize(), centre, radiusSquared))
+			results.push_back(obj);
+	}
+}
+
+void CollisionWorld::overlapBox(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const
+{
+	auto& candidates{getCandidateScratch()};
+	query(min, max, candidates);
+
+	for (const auto obj : candidates)
+	{
+		const auto& objectPos{obj->getPosition()};
+		if (overlapsBox(objectPos, objectPos + obj->getSize(), min, max))
+			results.push_back(obj);
+	}
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "aabbtree.h"
+#include "staticbvh.h"
+#include <glm/vec3.hpp>
+#include <vector>
+
+class GameObject;
+
+// Result of casting a ray or sphere through the collision world. Position is where the ray's origin (or sphere's centre) is at the time of impact, and Normal points away from the surface hit
+struct CastHit
+{
+	bool Hit{false};
+	float Distance{0.0f};
+	glm::vec3 Position{0.0f};
+	glm::vec3 Normal{0.0f};
+	GameObject* Object{nullptr};
+};
+
+// Class containing the collision acceleration structures for a level. Objects are classified when added: static objects go into an immutable, flattened BVH built once after the level has loaded, and dynamic objects go into a dynamic AABB tree that is refitted as they move. Per-tick maintenance cost therefore only depends on the moving objects.
+class CollisionWorld
+{
+public:
+	explicit CollisionWorld(float fatMargin);
+
+	// Register an object, using GameObject::isStatic to decide which structure it belongs in. Static objects are only queryable once buildStatic has been called
+	void add(GameObject& object);
+
+	// Build the static hierarchy from all static objects added so far -- to be called once the level has loaded
+	void buildStatic();
+
+	// Defer refitting dynamic objects while they move concurrently, see AabbTree::setDeferUpdates
+	void setDeferUpdates(bool defer);
+
+	// Get objects from both structures whose boxes may overlap the given shape. Static objects are returned before dynamic ones
+	void query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const;
+	void querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const;
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const;
+
+	// Scene queries -- unlike the functions above, these test against the exact collision boxes of objects rather than just finding candidates
+
+	// Find the closest object hit by a ray travelling up to maxDistance along a normalised direction
+	CastHit raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+
+	// Find the closest object hit by a sphere moving up to maxDistance along a normalised direction (e.g., a downward cast finds where a character will land). Objects the sphere starts overlapping are only hit if the sphere moves further into them
+	CastHit sphereCast(const glm::vec3& centre, float radius, const glm::vec3& direction, float maxDistance) const;
+
+	// Check nothing blocks a straight line between two points
+	bool hasLineOfSight(const glm::vec3& from, const glm::vec3& to) const;
+
+	// Get all objects overlapping the given shape
+	void overlapSphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const;
+	void overlapBox(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const;
+
+	int getStaticCount() const
+	{
+		return staticTree_.getObjectCount();
+	}
+
+	int getDynamicCount() const
+	{
+		return dynamicCount_;
+	}
+
+private:
+	StaticBvh staticTree_;
+	AabbTree dynamicTree_;
+	std::vector<GameObject*> pendingStatic_;
+	int dynamicCount_;
+};
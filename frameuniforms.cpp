@@ -0,0 +1,27 @@
+#include "frameuniforms.h"
+#include <glad/glad.h>
+
+FrameUniforms::FrameUniforms() : buffer_{}
+{
+}
+
+void FrameUniforms::update(const glm::mat4& projection, const glm::mat4& view, const glm::vec4& lightPosition, const glm::vec3& lightColor)
+{
+	// Buffer can't be created until there is an OpenGL context, so create it on first use. It stays bound to its binding point for the lifetime of the program
+	if (buffer_.get() == 0)
+	{
+		unsigned int buffer{};
+		glGenBuffers(1, &buffer);
+		glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(Data), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		glBindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, buffer);
+		buffer_ = BufferHandle{buffer, sizeof(Data)};
+	}
+
+	const auto data{Data{projection, view, lightPosition, glm::vec4{lightColor, 1.0f}}};
+
+	glBindBuffer(GL_UNIFORM_BUFFER, buffer_.get());
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Data), &data);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "gpuresource.h"
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Class owning the uniform buffer holding per-frame camera and lighting data. The buffer is bound to a fixed binding point that every shader program's "Frame" uniform block reads from, so the data is written once per frame however many programs there are.
+class FrameUniforms
+{
+public:
+	FrameUniforms();
+
+	// Write the frame's data to the buffer with a single buffer update
+	void update(const glm::mat4& projection, const glm::mat4& view, const glm::vec4& lightPosition, const glm::vec3& lightColor);
+
+	// Binding point of the "Frame" uniform block, matching the binding declared in the shaders
+	static constexpr unsigned int BindingPoint{0};
+
+private:
+	// Mirrors the std140 layout of the "Frame" block. The light colour is stored as a vec4, as std140 pads a vec3 followed by nothing to 16 bytes anyway
+	struct Data
+	{
+		glm::mat4 Projection{};
+		glm::mat4 View{};
+		glm::vec4 LightPosition{};
+		glm::vec4 LightColor{};
+	};
+
+	BufferHandle buffer_;
+};
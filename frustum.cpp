@@ -0,0 +1,130 @@
+#include "frustum.h"
+#include <glm/geometric.hpp>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#endif
+
+void SphereList::clear()
+{
+	X.clear();
+	Y.clear();
+	Z.clear();
+	Radius.clear();
+}
+
+void SphereList::add(const glm::vec3& centre, float radius)
+{
+	X.push_back(centre.x);
+	Y.push_back(centre.y);
+	Z.push_back(centre.z);
+	Radius.push_back(radius);
+}
+
+Frustum::Frustum() : planes_{}
+{
+}
+
+// Extract the planes from the rows of the matrix (Gribb and Hartmann's method), normalising them so plane distances are true distances that can be compared with sphere radii
+Frustum::Frustum(const glm::mat4& viewProjection) : planes_{}
+{
+	// GLM matrices are column-major, so gather each row across the columns
+	const auto row{[&viewProjection](int i)
+	{
+		return glm::vec4{viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]};
+	}};
+
+	planes_[0] = row(3) + row(0); // Left
+	planes_[1] = row(3) - row(0); // Right
+	planes_[2] = row(3) + row(1); // Bottom
+	planes_[3] = row(3) - row(1); // Top
+	planes_[4] = row(3) + row(2); // Near
+	planes_[5] = row(3) - row(2); // Far
+
+	for (auto& plane : planes_)
+		plane /= glm::length(glm::vec3{plane});
+}
+
+bool Frustum::containsSphere(const glm::vec3& centre, float radius) const
+{
+	for (const auto& plane : planes_)
+	{
+		if (plane.x * centre.x + plane.y * centre.y + plane.z * centre.z + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+// A sphere is visible if it isn't entirely behind any plane. Spheres left over after the last full SIMD batch are tested one at a time
+void Frustum::cullSpheres(const SphereList& spheres, std::vector<int>& visible) const
+{
+	const auto count{spheres.size()};
+	auto i{0};
+
+#if defined(__AVX2__)
+	const auto signMask{_mm256_set1_ps(-0.0f)};
+
+	for (; i + 8 <= count; i += 8)
+	{
+		const auto x{_mm256_loadu_ps(&spheres.X[i])};
+		const auto y{_mm256_loadu_ps(&spheres.Y[i])};
+		const auto z{_mm256_loadu_ps(&spheres.Z[i])};
+		const auto negativeRadius{_mm256_xor_ps(_mm256_loadu_ps(&spheres.Radius[i]), signMask)};
+
+		auto inside{_mm256_castsi256_ps(_mm256_set1_epi32(-1))};
+		for (const auto& plane : planes_)
+		{
+			const auto distance{_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), x), _mm256_mul_ps(_mm256_set1_ps(plane.y), y)), _mm256_mul_ps(_mm256_set1_ps(plane.z), z)), _mm256_set1_ps(plane.w))};
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+		}
+
+		const auto mask{_mm256_movemask_ps(inside)};
+		for (auto lane{0}; mask && lane < 8; ++lane)
+		{
+			if (mask & (1 << lane))
+				visible.push_back(i + lane);
+		}
+	}
+#elif defined(FRUSTUM_SSE2)
+	const auto signMask{_mm_set1_ps(-0.0f)};
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const auto x{_mm_loadu_ps(&spheres.X[i])};
+		const auto y{_mm_loadu_ps(&spheres.Y[i])};
+		const auto z{_mm_loadu_ps(&spheres.Z[i])};
+		const auto negativeRadius{_mm_xor_ps(_mm_loadu_ps(&spheres.Radius[i]), signMask)};
+
+		auto inside{_mm_castsi128_ps(_mm_set1_epi32(-1))};
+		for (const auto& plane : planes_)
+		{
+			const auto distance{_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y)), _mm_mul_ps(_mm_set1_ps(plane.z), z)), _mm_set1_ps(plane.w))};
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		const auto mask{_mm_movemask_ps(inside)};
+		for (auto lane{0}; mask && lane < 4; ++lane)
+		{
+			if (mask & (1 << lane))
+				visible.push_back(i + lane);
+		}
+	}
+#endif
+
+	cullSpheresScalar(spheres, i, visible);
+}
+
+void Frustum::cullSpheresScalar(const SphereList& spheres, int first, std::vector<int>& visible) const
+{
+	const auto count{spheres.size()};
+
+	for (auto i{first}; i < count; ++i)
+	{
+		if (containsSphere(glm::vec3{spheres.X[i], spheres.Y[i], spheres.Z[i]}, spheres.Radius[i]))
+			visible.push_back(i);
+	}
+}
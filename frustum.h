@@ -0,0 +1,43 @@
+#pragma once
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+// Bounding spheres stored as a structure of arrays (separate arrays per component), so several can be tested at once using SIMD instructions
+struct SphereList
+{
+	std::vector<float> X{};
+	std::vector<float> Y{};
+	std::vector<float> Z{};
+	std::vector<float> Radius{};
+
+	void clear();
+	void add(const glm::vec3& centre, float radius);
+
+	int size() const
+	{
+		return static_cast<int>(X.size());
+	}
+};
+
+// Class representing the six planes of a view frustum in world space, extracted from a combined projection and view matrix. Used to skip drawing objects that can't be seen by the camera.
+class Frustum
+{
+public:
+	Frustum();
+	explicit Frustum(const glm::mat4& viewProjection);
+
+	// Whether any part of the sphere may be inside the frustum. Spheres near a corner of the frustum may be reported visible when they aren't, but visible spheres are never rejected
+	bool containsSphere(const glm::vec3& centre, float radius) const;
+
+	// Append the indices of all spheres that may be inside the frustum to visible, in ascending order. Uses AVX2 (8 spheres per instruction) or SSE (4 spheres per instruction) where available
+	void cullSpheres(const SphereList& spheres, std::vector<int>& visible) const;
+
+private:
+	// Plane normals point into the frustum, so a point is inside a plane when its signed distance is positive
+	glm::vec4 planes_[6];
+
+	void cullSpheresScalar(const SphereList& spheres, int first, std::vector<int>& visible) const;
+};
@@ -4,26 +4,48 @@
 #include "platform.h"
 #include <GLFW/glfw3.h>
 #include <glm/ext/matrix_clip_space.hpp>
+#include <glm/matrix.hpp>
+#include <algorithm>
 #include <tuple>
 
-Game::Game(int width, int height) : State{GameState::GAME_ACTIVE}, Keys{}, ScreenWidth{width}, ScreenHeight{height}, GameObjects{}, Shaders{}, PlayerCharacter{glm::vec3{1.0f, 1.5f, 1.0f}, glm::vec3{3.0f}, 0.85f}
+namespace
+{
+	// Number of objects and characters updated by each job when updates are spread across threads
+	constexpr auto objectGrainSize{64};
+	constexpr auto characterGrainSize{16};
+
+	// Time spent each frame uploading models loaded in the background, small enough to leave most of a 60Hz frame for everything else
+	constexpr auto uploadBudgetSeconds{0.002};
+}
+
+Game::Game(int width, int height) : State{GameState::GAME_ACTIVE}, Keys{}, ScreenWidth{width}, ScreenHeight{height}, WorkerCount{JobSystem::getDefaultWorkerCount()}, Jobs{}, Geometry{}, Assets{Geometry}, GameObjects{}, Shaders{}, PlayerCharacter{glm::vec3{1.0f, 1.5f, 1.0f}, glm::vec3{3.0f}, 0.85f}, Agents{}, Collisions{1.0f}, ObjectIndices{}, Sky{}, Renderer{}, Occlusion{}, FrameData{}, Projection{1.0f}
 {
 }
 
 // Initialise the game, including creating game objects and setting their initial positions, and setting other unchanging values
 void Game::init()
 {
+	Jobs = std::make_unique<JobSystem>(WorkerCount);
+	Renderer.setOcclusionCuller(&Occlusion);
+	Assets.setJobSystem(Jobs.get());
+
+	// Start reading assets on worker threads, so they load while shaders compile on this one
+	const auto platformLoad{Assets.loadModelAsync("media/platform/platform.obj")};
+	const auto skyImage{Assets.loadImageAsync("media/skycube/skycube.png")};
+
 	// Initialise shaders
 	Shaders.emplace_back(Shader{"shaders/shader.vert", "shaders/shader.frag"});
-	Shaders.emplace_back(Shader{"shaders/skybox.vert", "shaders/skybox.frag"});
+	auto skyShader{Shader{"shaders/skybox.vert", "shaders/skybox.frag"}};
+
+	// Nothing can be placed until its assets are loaded, so upload them all now rather than a few per frame
+	Assets.finishLoading();
 
-	// Create sky cube
-	const auto skyboxModel{Model{"media/skycube/skycube.obj"}};
-	GameObjects.emplace_back(std::make_unique<VisibleObject>(skyboxModel, Shaders[1], glm::vec3{0.0f}, glm::vec3{0.0f}, glm::vec3{0.0f}, glm::vec3{80.0f}));
+	// Create sky, drawn separately from game objects once everything else has been drawn
+	Sky = std::make_unique<Skybox>(*skyImage.get(), skyShader);
 
 
 	// PLATFORMS START
-	const auto platformModel{Model{"media/platform/platform.obj"}};
+	const auto platformModel{platformLoad.get()};
 	constexpr auto platformSize{glm::vec3{2.0f, 1.0f, 2.0f}};
 
 	GameObjects.emplace_back
@@ -64,19 +86,24 @@ void Game::init()
 
 	// PLATFORMS END
 
-	// Initialise all game objects
-	for (auto& obj : GameObjects)
+	// Initialise all game objects and register them for collision checks
+	for (auto i{0}; i < static_cast<int>(GameObjects.size()); ++i)
 	{
+		auto& obj{GameObjects[i]};
 		obj->init();
+
+		Collisions.add(*obj);
+		ObjectIndices.emplace(obj.get(), i);
 	}
 
+	// Static objects are all known by now, so their acceleration structure can be built
+	Collisions.buildStatic();
+
+	// All models are loaded, so storage only needed while uploading them can be freed
+	Geometry.releaseScratch();
+
 	// Projection matrix doesn't change so can be initialised here
-	const auto projection{glm::perspective(glm::radians(PlayerCharacter.getFov()), static_cast<float>(ScreenWidth) / static_cast<float>(ScreenHeight), 0.1f, 1000.0f)};
-	for (const auto& shader : Shaders)
-	{
-		shader.use();
-		shader.setUniform("projection", projection);
-	}
+	Projection = glm::perspective(glm::radians(PlayerCharacter.getFov()), static_cast<float>(ScreenWidth) / static_cast<float>(ScreenHeight), 0.1f, 1000.0f);
 }
 
 // Handle received keyboard input by triggering functionality in controllable GameObjects
@@ -95,64 +122,189 @@ void Game::processInput()
 		PlayerCharacter.processKeyboard(PlayerMovement::JUMP_PRESSED);
 	if (!Keys[GLFW_KEY_SPACE])
 		PlayerCharacter.processKeyboard(PlayerMovement::JUMP_RELEASED);
+
+	// Agents run forwards, jumping whenever they land
+	for (auto& agent : Agents)
+	{
+		agent.processKeyboard(PlayerMovement::FORWARD);
+		agent.processKeyboard(agent.getGrounded() ? PlayerMovement::JUMP_PRESSED : PlayerMovement::JUMP_RELEASED);
+	}
 }
 
 // Update the positions of GameObjects, apply forces, check collisions, and perform other relevant per-tick checks (e.g., game over)
 void Game::update(float deltaTime)
 {
-	// Tick player character separately due to architectural constraints
-	PlayerCharacter.tick(deltaTime);
+	// Move characters separately due to architectural constraints. Their movement is swept through the level so fast movement can't tunnel through thin platforms
+	moveAndSlide(PlayerCharacter);
+	Jobs->parallelFor(0, static_cast<int>(Agents.size()), characterGrainSize, [this](int begin, int end)
+	{
+		for (auto i{begin}; i < end; ++i)
+			moveAndSlide(Agents[i]);
+	});
 
-	// Move any objects that have velocity
-	for (auto& obj : GameObjects)
+	// Move any objects that have velocity. Objects move independently of each other, so are spread across threads, with changes to collision structures deferred until all have moved
+	Collisions.setDeferUpdates(true);
+	Jobs->parallelFor(0, static_cast<int>(GameObjects.size()), objectGrainSize, [this, deltaTime](int begin, int end)
 	{
-		obj->tick(deltaTime);
-	}
+		for (auto i{begin}; i < end; ++i)
+			GameObjects[i]->tick(deltaTime);
+	});
+	Collisions.setDeferUpdates(false);
 
 	// After do object movement, check apply gravity and do collisions
-	applyGravity();
-	doCollisions();
-	checkGameOver();
-
-	// Set shader values
-	const auto view{PlayerCharacter.getViewMatrix()}; // View matrix based on the player's view
-	const auto lightPos{view * glm::vec4{-0.75, -0.5, -0.3, 0.0}}; // Light position in view space
-	constexpr auto lightColor{glm::vec3{1.0}}; // Light colour
-	for (const auto& shader : Shaders)
-	{
-		shader.use();
-		shader.setUniform("view", view);
-		shader.setUniform("light.position", lightPos);
-		shader.setUniform("light.color", lightColor);
-	}
+	updateCharacter(PlayerCharacter);
+	updateCharacters(Agents);
 }
 
-// Render all GameObjects and get the latest view matrix (which defines the player's view) from player character
+// Render all GameObjects within the player's view, drawing objects that share a model and shader with a single instanced draw call per mesh
 void Game::render()
 {
+	// Models loaded in the background are uploaded a few at a time, so loading them never stalls a frame
+	Assets.processUploads(uploadBudgetSeconds);
+
 	// Don't render anything without shaders
 	if (Shaders.empty())
 	{
 		return;
 	}
 
+	// Set shader values shared by all programs
+	const auto view{PlayerCharacter.getViewMatrix()}; // View matrix based on the player's view
+	const auto lightPos{view * glm::vec4{-0.75, -0.5, -0.3, 0.0}}; // Light position in view space
+	constexpr auto lightColor{glm::vec3{1.0}}; // Light colour
+	FrameData.update(Projection, view, lightPos, lightColor);
+
+	// Measure objects' size on screen from the camera, the translation of the inverse view matrix
+	const auto cameraPosition{glm::vec3{glm::inverse(view)[3]}};
+	Renderer.setCamera(cameraPosition, Projection[1][1]);
+
+	// Draw the platforms covering the most of the screen into the occlusion buffer, so objects behind them are skipped before being submitted
+	Occlusion.beginFrame(Projection * view, cameraPosition);
+	for (const auto& obj : GameObjects)
+	{
+		glm::vec3 min{};
+		glm::vec3 max{};
+		if (obj->getOccluderBounds(min, max))
+			Occlusion.addOccluder(min, max);
+	}
+	Occlusion.rasterizeOccluders();
+
 	for (const auto& obj : GameObjects)
 	{
-		obj->draw();
+		obj->draw(Renderer);
 	}
+
+	// Skip drawing objects the player can't see
+	Renderer.flush(Frustum{Projection * view});
+
+	// Sky is drawn last, so it is only shaded where no object was drawn
+	Sky->draw();
 }
 
-// Check for and resolve collisions between the player character and game objects. Also set the grounded state of the player (used for jumping logic)
-void Game::doCollisions()
+// Apply forces, resolve collisions, and perform per-tick checks for a character once all objects have moved
+void Game::updateCharacter(Character& character)
 {
-	static auto groundColCount{0};
+	applyGravity(character);
+	doCollisions(character);
+	updateGrounded(character);
+	checkGameOver(character);
+}
 
-	for (const auto& obj : GameObjects)
+// Batched version of updateCharacter. Characters are stored by value, so every call is resolved statically rather than through a virtual call per character. Characters don't collide with each other, so they are spread across threads
+void Game::updateCharacters(std::vector<Character>& characters)
+{
+	Jobs->parallelFor(0, static_cast<int>(characters.size()), characterGrainSize, [this, &characters](int begin, int end)
+	{
+		for (auto i{begin}; i < end; ++i)
+			updateCharacter(characters[i]);
+	});
+}
+
+// Consume the character's velocity by sweeping its collision sphere through the level, stopping at the first surface hit and sliding along it with the remaining movement
+void Game::moveAndSlide(Character& character)
+{
+	constexpr auto maxIterations{4};
+	constexpr auto skinWidth{0.001f};
+
+	const auto radius{character.getRadius()};
+	auto centre{character.getPosition() + radius};
+	auto displacement{character.getVelocity()};
+
+	for (auto i{0}; i < maxIterations; ++i)
 	{
-		const auto playerPos{PlayerCharacter.getPosition()};
-		const auto playerRad{PlayerCharacter.getRadius()};
+		const auto distance{length(displacement)};
+		if (distance <= 0.0f)
+			break;
+
+		const auto hit{Collisions.sphereCast(centre, radius, displacement / distance, distance)};
+		if (!hit.Hit)
+		{
+			centre += displacement;
 
-		const auto collision{checkCollision(PlayerCharacter, *obj)};
+			break;
+		}
+
+		// Move up to the surface, leaving a small gap so the next cast starts outside of it
+		centre = hit.Position + hit.Normal * skinWidth;
+
+		// Slide along the surface using the remaining movement, minus the part pointing into the surface
+		const auto remaining{displacement * (1.0f - hit.Distance / distance)};
+		displacement = remaining - hit.Normal * dot(remaining, hit.Normal);
+	}
+
+	character.setPosition(centre - radius);
+	character.setVelocity(glm::vec3{0.0f});
+}
+
+// The character is grounded if a short downward spherecast hits an upward facing surface (used for jumping logic)
+void Game::updateGrounded(Character& character) const
+{
+	// Gravity moves the character this far each tick, so anything closer will be landed on next tick
+	constexpr auto probeDistance{0.05f};
+	constexpr auto minGroundNormalY{0.7f};
+
+	const auto radius{character.getRadius()};
+	const auto hit{Collisions.sphereCast(character.getPosition() + radius, radius, glm::vec3{0.0f, -1.0f, 0.0f}, probeDistance)};
+
+	character.setGrounded(hit.Hit && hit.Normal.y >= minGroundNormalY);
+}
+
+// Check for and resolve collisions between a character and game objects
+void Game::doCollisions(Character& character)
+{
+	// Only objects near the character can collide with it. The query is padded by the character's radius to cover the distance the character can be pushed while resolving earlier collisions
+	const auto radius{character.getRadius()};
+	thread_local CollisionScratch scratch{};
+	scratch.Candidates.clear();
+	Collisions.querySphere(character.getPosition() + radius, radius * 2.0f, scratch.Candidates);
+
+	// Which of several overlapping boxes pushes the character first changes where it ends up, so resolve them in GameObjects order, as checking every object did, rather than the order the collision structures found them in
+	std::sort(scratch.Candidates.begin(), scratch.Candidates.end(), [this](const GameObject* a, const GameObject* b)
+	{
+		return ObjectIndices.at(a) < ObjectIndices.at(b);
+	});
+
+	scratch.Colliders.clear();
+	for (const auto obj : scratch.Candidates)
+		scratch.Colliders.add(obj->getPosition(), obj->getSize());
+
+	// Resolve collisions with candidates in that order, each checked from the character's position after resolving the ones before it. Test all remaining candidates at once, then resolve the first hit and test again from where it pushed the character
+	auto next{0};
+	while (true)
+	{
+		scratch.Hits.clear();
+		scratch.Colliders.testSphere(character.getPosition() + radius, radius, scratch.Hits);
+
+		const auto hit{std::lower_bound(scratch.Hits.begin(), scratch.Hits.end(), next)};
+		if (hit == scratch.Hits.end())
+			break;
+
+		next = *hit + 1;
+
+		const auto playerPos{character.getPosition()};
+		const auto playerRad{character.getRadius()};
+
+		const auto collision{checkCollision(character, *scratch.Candidates[*hit])};
 
 		// If collision occurred...
 		if (std::get<0>(collision))
@@ -167,13 +319,13 @@ void Game::doCollisions()
 				if (dir == Direction::X_POS)
 				{
 					const auto newX{playerPos.x - penetration};
-					PlayerCharacter.setPosition(glm::vec3{newX, playerPos.y, playerPos.z});
+					character.setPosition(glm::vec3{newX, playerPos.y, playerPos.z});
 				}
 
 				if (dir == Direction::X_NEG)
 				{
 					const auto newX{playerPos.x + penetration};
-					PlayerCharacter.setPosition(glm::vec3{newX, playerPos.y, playerPos.z});
+					character.setPosition(glm::vec3{newX, playerPos.y, playerPos.z});
 				}
 			}
 			else if (dir == Direction::Y_POS || dir == Direction::Y_NEG)
@@ -183,14 +335,12 @@ void Game::doCollisions()
 				if (dir == Direction::Y_POS)
 				{
 					const auto newY{playerPos.y - penetration};
-					PlayerCharacter.setPosition(glm::vec3{playerPos.x, newY, playerPos.z});
+					character.setPosition(glm::vec3{playerPos.x, newY, playerPos.z});
 				}
 				else if (dir == Direction::Y_NEG) // Top surface of obstacle
 				{
-					++groundColCount;
-
 					const auto newY{playerPos.y + penetration};
-					PlayerCharacter.setPosition(glm::vec3{playerPos.x, newY, playerPos.z});
+					character.setPosition(glm::vec3{playerPos.x, newY, playerPos.z});
 				}
 			}
 			else
@@ -200,74 +350,61 @@ void Game::doCollisions()
 				if (dir == Direction::Z_POS)
 				{
 					const auto newZ{playerPos.z - penetration};
-					PlayerCharacter.setPosition(glm::vec3{playerPos.x, playerPos.y, newZ});
+					character.setPosition(glm::vec3{playerPos.x, playerPos.y, newZ});
 				}
 				else if (dir == Direction::Z_NEG)
 				{
 					const auto newZ{playerPos.z + penetration};
-					PlayerCharacter.setPosition(glm::vec3{playerPos.x, playerPos.y, newZ});
+					character.setPosition(glm::vec3{playerPos.x, playerPos.y, newZ});
 				}
 			}
 		}
 	}
-
-	// Collision with ground (top surface of objects) must occur for a minimum period before player is considered grounded
-	if (groundColCount >= 1)
-	{
-		PlayerCharacter.setGrounded(true);
-		groundColCount = 0;
-	}
 }
 
-// Apply the force of gravity to the player, adding negative Y-axis velocity
-void Game::applyGravity()
+// Apply the force of gravity to a character, adding negative Y-axis velocity
+void Game::applyGravity(Character& character)
 {
 	constexpr auto gravity{0.05f};
 
 	// Apply force of gravity
-	PlayerCharacter.addVelocity(glm::vec3{0.0f, -gravity, 0.0f});
+	character.addVelocity(glm::vec3{0.0f, -gravity, 0.0f});
 }
 
-// Check if the player is has fallen too far and if so reset their position
-void Game::checkGameOver()
+// Check if a character has fallen too far and if so reset their position
+void Game::checkGameOver(Character& character)
 {
 	constexpr auto minHeight{-10.0f};
 	constexpr auto startPos{glm::vec3{1.0f, 1.5f, 1.0f}};
 
-	if (PlayerCharacter.getPosition().y <= minHeight)
-		PlayerCharacter.setPosition(startPos);
+	if (character.getPosition().y <= minHeight)
+		character.setPosition(startPos);
 }
 
-// Get the direction the player is a colliding with an object from
-Direction Game::getVectorDirection(const glm::vec3& target)
+// Add simulated player-like characters to the game, spread around the player's start position. Used for load testing
+void Game::spawnAgents(int count)
 {
-	constexpr glm::vec3 directions[]
-	{
-		glm::vec3{1.0f, 0.0f, 0.0f}, // Positive X
-		glm::vec3{-1.0f, 0.0f, 0.0f}, // Negative X
-		glm::vec3{0.0f, 1.0f, 0.0f}, // Positive Y
-		glm::vec3{0.0f, -1.0f, 0.0f}, // Negative Y
-		glm::vec3{0.0f, 0.0f, 1.0f}, // Positive Z
-		glm::vec3{0.0f, 0.0f, -1.0f} // Negative Z
-	};
-
-	auto max{0.0f};
-
-	auto bestMatch{-1};
+	constexpr auto startPos{glm::vec3{1.0f, 1.5f, 1.0f}};
+	constexpr auto spacing{0.1f};
+	constexpr auto agentsPerRow{32};
 
-	for (auto i{0}; i < 6; ++i)
+	Agents.reserve(Agents.size() + count);
+	for (auto i{0}; i < count; ++i)
 	{
-		const auto dotProduct{dot(normalize(target), directions[i])};
-
-		if (dotProduct > max)
-		{
-			max = dotProduct;
-
-			bestMatch = i;
-		}
+		const auto offset{glm::vec3{static_cast<float>(i % agentsPerRow), 0.0f, static_cast<float>(i / agentsPerRow)} * spacing};
+		Agents.emplace_back(startPos + offset, glm::vec3{3.0f}, 0.85f);
 	}
+}
+
+// Clamped to a count the job system can sensibly run, as more threads than cores only add contention
+void Game::setWorkerCount(int count)
+{
+	WorkerCount = std::clamp(count, 0, JobSystem::MaxWorkerCount);
+}
 
-	return static_cast<Direction>(bestMatch);
+const InstancedRenderer& Game::getRenderer() const
+{
+	return Renderer;
 }
 
 // Set the pressed state of a particular key
@@ -290,47 +427,6 @@ void Game::setScrollInput(float xOffset, float yOffset)
 // Check for collision between AABB objects and a player character defined by a sphere
 Collision Game::checkCollision(const Character& camera, const GameObject& object)
 {
-	const auto cameraPos{camera.getPosition()};
-	const auto cameraRad{camera.getRadius()};
-
 	// Find camera centre by adding radius to position
-	const auto cameraCentre{cameraPos + cameraRad};
-
-	// Find ABB centre and half-extents
-	const auto objectSize{object.getSize()};
-	const auto objectPos{object.getPosition()};
-	const auto aabbHalfExtents
-	{
-		glm::vec3
-		{
-			objectSize.x / 2.0f,
-			objectSize.y / 2.0f,
-			objectSize.z / 2.0f
-		}
-	};
-	const auto aabbCentre
-	{
-		glm::vec3
-		{
-			objectPos.x + aabbHalfExtents.x,
-			objectPos.y + aabbHalfExtents.y,
-			objectPos.z + aabbHalfExtents.z
-		}
-	};
-
-	// Find difference between both centres
-	const auto difference{cameraCentre - aabbCentre};
-	const auto clampedDiff{clamp(difference, -aabbHalfExtents, aabbHalfExtents)};
-
-	// Find position closest to camera (the circle)
-	const auto closestPoint{aabbCentre + clampedDiff};
-
-	// Get vector between circle's centre and closest AABB point, and check if length is less than or equal to circle's radius
-	const auto length{closestPoint - cameraCentre};
-
-	// If collision...
-	if (glm::length(length) < cameraRad)
-		return std::make_tuple(true, getVectorDirection(length), length);
-
-	return std::make_tuple(false, Direction::X_POS, glm::vec3{0.0f});
+	return checkSphereBox(camera.getPosition() + camera.getRadius(), camera.getRadius(), object.getPosition(), object.getSize());
 }
@@ -1,7 +1,18 @@
 #pragma once
 
+#include "assetmanager.h"
 #include "character.h"
+#include "colliderstore.h"
+#include "collision.h"
+#include "collisionworld.h"
+#include "frameuniforms.h"
+#include "geometrymanager.h"
+#include "instancedrenderer.h"
+#include "jobsystem.h"
+#include "skybox.h"
+#include <glm/mat4x4.hpp>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 enum class GameState
@@ -12,19 +23,14 @@ enum class GameState
 	GAME_DEBUG
 };
 
-enum class Direction
+// Reusable storage for a character's collision pass, kept per thread so characters can be updated concurrently
+struct CollisionScratch
 {
-	X_POS,
-	X_NEG,
-	Y_POS,
-	Y_NEG,
-	Z_POS,
-	Z_NEG
+	std::vector<GameObject*> Candidates{};
+	ColliderStore Colliders{};
+	std::vector<int> Hits{};
 };
 
-// Type to contain data about collisions between the player and other objects
-using Collision = std::tuple<bool, Direction, glm::vec3>;
-
 // Class representing an instance of the game, defining its initialisation, update, and render behaviour. Also receives inputs from external window system, and maintains references to in-game objects and the player character.
 class Game
 {
@@ -37,6 +43,13 @@ public:
 	void setKeyState(int key, bool pressed);
 	void setMouseInput(float xOffset, float yOffset);
 	void setScrollInput(float xOffset, float yOffset);
+	void spawnAgents(int count);
+
+	// Get the renderer, e.g., to report how many objects were drawn and culled last frame
+	const InstancedRenderer& getRenderer() const;
+
+	// Set the number of worker threads used to update the game, zero giving the single-threaded reference mode. Must be called before init
+	void setWorkerCount(int count);
 
 private:
 	GameState State;
@@ -44,13 +57,48 @@ private:
 	int ScreenWidth;
 	int ScreenHeight;
 
+	// Worker threads that independent per-object and per-character updates are spread across
+	int WorkerCount;
+	std::unique_ptr<JobSystem> Jobs;
+
+	// Vertex and index buffers shared by all models. Declared before anything holding models, so it is destroyed after the meshes that free their space in it
+	GeometryManager Geometry;
+
+	// Models shared by every object using them, each loaded once
+	AssetManager Assets;
+
 	std::vector<std::unique_ptr<GameObject>> GameObjects;
 	std::vector<Shader> Shaders;
 	Character PlayerCharacter;
 
-	void doCollisions();
-	void applyGravity();
-	void checkGameOver();
+	// Additional simulated characters, stored by value so they can be updated in a batch
+	std::vector<Character> Agents;
+
+	// Acceleration structures for collision checks, so only objects near the player are tested each tick
+	CollisionWorld Collisions;
+
+	// Index of each object in GameObjects. The collision structures return objects in an order of their own, so candidates are sorted by this to resolve collisions in the order objects were created
+	std::unordered_map<const GameObject*, int> ObjectIndices;
+
+	// Sky drawn behind all objects. Created in init, as it can't be created until there is an OpenGL context
+	std::unique_ptr<Skybox> Sky;
+
+	// Batches objects sharing a model and shader into instanced draw calls
+	InstancedRenderer Renderer;
+
+	// Depth buffer of the largest platforms, rasterized on the CPU, that hidden objects are culled against
+	OcclusionCuller Occlusion;
+
+	// Camera and lighting data shared by all shader programs through a uniform buffer
+	FrameUniforms FrameData;
+	glm::mat4 Projection;
+
+	void updateCharacter(Character& character);
+	void updateCharacters(std::vector<Character>& characters);
+	void moveAndSlide(Character& character);
+	void doCollisions(Character& character);
+	void updateGrounded(Character& character) const;
+	void applyGravity(Character& character);
+	void checkGameOver(Character& character);
 	static Collision checkCollision(const Character& camera, const GameObject& object);
-	static Direction getVectorDirection(const glm::vec3& target);
 };
@@ -1,15 +1,16 @@
 #include "gameobject.h"
+#include "broadphase.h"
 
 GameObject::GameObject
 (
 	const glm::vec3& position,
 	const glm::vec3& size
 )
-	: position_{position}, size_{size}
+	: position_{position}, size_{size}, velocity_{0.0f}, broadphase_{nullptr}, broadphaseProxy_{-1}
 {
 }
 
-void GameObject::draw() const
+void GameObject::draw(InstancedRenderer& renderer) const
 {
 }
 
@@ -20,6 +21,8 @@ void GameObject::move()
 
 	// Reset velocity to prevent constantly increasing speed
 	velocity_ = glm::vec3{0.0};
+
+	updateBroadphase();
 }
 
 void GameObject::init()
@@ -29,6 +32,8 @@ void GameObject::init()
 void GameObject::setPosition(const glm::vec3& newPos)
 {
 	position_ = newPos;
+
+	updateBroadphase();
 }
 
 const glm::vec3& GameObject::getPosition() const
@@ -39,6 +44,8 @@ const glm::vec3& GameObject::getPosition() const
 void GameObject::setSize(const glm::vec3& size)
 {
 	size_ = size;
+
+	updateBroadphase();
 }
 
 const glm::vec3& GameObject::getSize() const
@@ -51,6 +58,11 @@ void GameObject::addVelocity(const glm::vec3& direction)
 	velocity_ += direction;
 }
 
+void GameObject::setVelocity(const glm::vec3& velocity)
+{
+	velocity_ = velocity;
+}
+
 const glm::vec3& GameObject::getVelocity() const
 {
 	return velocity_;
@@ -60,3 +72,31 @@ void GameObject::tick(float deltaTime)
 {
 	move();
 }
+
+bool GameObject::isStatic() const
+{
+	return false;
+}
+
+bool GameObject::getOccluderBounds(glm::vec3& min, glm::vec3& max) const
+{
+	return false;
+}
+
+void GameObject::setBroadphase(Broadphase* broadphase, int proxy)
+{
+	broadphase_ = broadphase;
+	broadphaseProxy_ = proxy;
+}
+
+int GameObject::getBroadphaseProxy() const
+{
+	return broadphaseProxy_;
+}
+
+// Notify the broadphase the object is registered in (if any) that its collision box has changed
+void GameObject::updateBroadphase()
+{
+	if (broadphase_)
+		broadphase_->update(broadphaseProxy_, position_, size_);
+}
@@ -3,6 +3,9 @@
 #include "shader.h"
 #include <glm/vec3.hpp>
 
+class Broadphase;
+class InstancedRenderer;
+
 // Class representing an in-game entity with a position, velocity, collision size. Contains an overridable method for drawing an associated model, which is to be implemented in derived classes.
 class GameObject
 {
@@ -10,11 +13,18 @@ public:
 	virtual ~GameObject() = default;
 	GameObject(const glm::vec3& position, const glm::vec3& size);
 
-	virtual void draw() const;
+	// Submit the object's model, if it has one, to the renderer for drawing this frame
+	virtual void draw(InstancedRenderer& renderer) const;
 	virtual void move();
 	virtual void init();
 	virtual void tick(float deltaTime);
 
+	// Whether the object never moves once the level is loaded, allowing it to be stored in immutable acceleration structures
+	virtual bool isStatic() const;
+
+	// Get a box lying entirely within the solid volume the object is drawn as, so it can hide objects behind it from the camera. Returns false if the object has no such volume
+	virtual bool getOccluderBounds(glm::vec3& min, glm::vec3& max) const;
+
 	void setPosition(const glm::vec3& newPos);
 	const glm::vec3& getPosition() const;
 
@@ -22,10 +32,21 @@ public:
 	const glm::vec3& getSize() const;
 
 	void addVelocity(const glm::vec3& direction);
+	void setVelocity(const glm::vec3& velocity);
 	const glm::vec3& getVelocity() const;
 
+	// Link the object to the broadphase it is registered in, so the broadphase can be kept up to date as the object moves
+	void setBroadphase(Broadphase* broadphase, int proxy);
+	int getBroadphaseProxy() const;
+
 protected:
 	glm::vec3 position_;
 	glm::vec3 size_;
 	glm::vec3 velocity_;
+
+private:
+	Broadphase* broadphase_;
+	int broadphaseProxy_;
+
+	void updateBroadphase();
 };
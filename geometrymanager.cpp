@@ -0,0 +1,476 @@
+#include "geometrymanager.h"
+#include "mesh.h"
+#include <glad/glad.h>
+#include <glm/geometric.hpp>
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/vec4.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+	// Initial buffer sizes, enough for several models before any buffer needs to grow
+	constexpr long long initialVertexCapacity{1 << 20};
+	constexpr long long initialIndexCapacity{1 << 20};
+
+	// Vertex buffer binding point the per-vertex data is read from
+	constexpr unsigned int vertexBinding{0};
+
+	// Describes one per-vertex attribute of a stored layout
+	struct Attribute
+	{
+		unsigned int Location;
+		int Size;
+		unsigned int Type;
+		bool Normalised;
+		unsigned int Offset;
+	};
+}
+
+GeometryManager::GeometryManager(VertexFormat format) : format_{format}, pools_{std::make_shared<std::vector<Pool>>()}, vertexData_{}, indexData_{}
+{
+}
+
+GeometryAllocation GeometryManager::add(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, bool needsTangents)
+{
+	return add(pack(vertices, lods, needsTangents));
+}
+
+// Place the mesh's data in the first free ranges of its pool large enough to hold it, or after all other meshes if there are none, growing the pool's buffers (doubling them until the mesh fits) if needed
+GeometryAllocation GeometryManager::add(const PackedGeometry& packed)
+{
+	const auto poolIndex{getPool(packed.Layout, packed.ShortIndices)};
+	auto& pool{(*pools_)[poolIndex]};
+
+	const auto vertexBytes{packed.VertexBytes};
+	const auto indexBytes{packed.IndexBytes};
+
+	// Every range in a pool is a whole number of vertices or indices, so offsets stay aligned to them however ranges are reused
+	const auto usedVertexBytes{pool.VertexEnd};
+	const auto usedIndexBytes{pool.IndexEnd};
+	const auto vertexOffset{allocate(pool.FreeVertices, pool.VertexEnd, vertexBytes)};
+	const auto indexOffset{allocate(pool.FreeIndices, pool.IndexEnd, indexBytes)};
+
+	if (pool.VertexEnd > pool.VertexCapacity)
+	{
+		while (pool.VertexEnd > pool.VertexCapacity)
+			pool.VertexCapacity *= 2;
+
+		grow(pool.VertexBuffer, usedVertexBytes, pool.VertexCapacity);
+		glVertexArrayVertexBuffer(pool.Vao.get(), vertexBinding, pool.VertexBuffer.get(), 0, pool.VertexStride);
+	}
+
+	if (pool.IndexEnd > pool.IndexCapacity)
+	{
+		while (pool.IndexEnd > pool.IndexCapacity)
+			pool.IndexCapacity *= 2;
+
+		grow(pool.IndexBuffer, usedIndexBytes, pool.IndexCapacity);
+		glVertexArrayElementBuffer(pool.Vao.get(), pool.IndexBuffer.get());
+	}
+
+	// Indices stay relative to the mesh's first vertex, with the base vertex applied when drawing, so 16-bit indices work however full the pool is
+	glNamedBufferSubData(pool.VertexBuffer.get(), static_cast<GLintptr>(vertexOffset), static_cast<GLsizeiptr>(vertexBytes), packed.VertexData);
+	glNamedBufferSubData(pool.IndexBuffer.get(), static_cast<GLintptr>(indexOffset), static_cast<GLsizeiptr>(indexBytes), packed.IndexData);
+
+	auto geometry{MeshGeometry{}};
+	geometry.Vao = pool.Vao.get();
+	geometry.IndexType = packed.ShortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	geometry.BaseVertex = static_cast<int>(vertexOffset / pool.VertexStride);
+	for (const auto& lod : packed.Lods)
+		geometry.Lods.push_back(IndexRange{static_cast<int>(indexOffset / pool.IndexSize) + lod.FirstIndex, lod.IndexCount});
+
+	geometry.Pool = poolIndex;
+	geometry.VertexBytes = ByteRange{vertexOffset, vertexBytes};
+	geometry.IndexBytes = ByteRange{indexOffset, indexBytes};
+
+	pool.VertexBytes += vertexBytes;
+	pool.IndexBytes += indexBytes;
+
+	return GeometryAllocation{*this, std::move(geometry)};
+}
+
+// Levels of detail are stored one after another, so note where each starts within the packed indices
+PackedGeometry GeometryManager::pack(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, bool needsTangents)
+{
+	auto packed{PackedGeometry{}};
+	packed.Layout = getLayout(needsTangents);
+	packed.ShortIndices = vertices.size() <= MaxShortIndexVertices;
+
+	const auto indexSize{packed.ShortIndices ? sizeof(std::uint16_t) : sizeof(unsigned int)};
+
+	packVertices(vertices, packed.Layout);
+	indexData_.clear();
+	for (const auto& indices : lods)
+	{
+		packed.Lods.push_back(IndexRange{static_cast<int>(indexData_.size() / indexSize), static_cast<int>(indices.size())});
+		packIndices(indices, packed.ShortIndices);
+	}
+
+	packed.VertexData = vertexData_.data();
+	packed.VertexBytes = static_cast<long long>(vertexData_.size());
+	packed.IndexData = indexData_.data();
+	packed.IndexBytes = static_cast<long long>(indexData_.size());
+
+	return packed;
+}
+
+VertexLayout GeometryManager::getLayout(bool needsTangents) const
+{
+	if (format_ == VertexFormat::FULL)
+		return VertexLayout::FULL;
+
+	return needsTangents ? VertexLayout::PACKED_TANGENTS : VertexLayout::PACKED;
+}
+
+int GeometryManager::getVertexStride(VertexLayout layout)
+{
+	switch (layout)
+	{
+	case VertexLayout::PACKED:
+		return sizeof(PackedVertex);
+	case VertexLayout::PACKED_TANGENTS:
+		return sizeof(PackedTangentVertex);
+	default:
+		return sizeof(Vertex);
+	}
+}
+
+// Draws already issued may still read the mesh's data, so the ranges are only freed once the GPU has caught up, rather than risking new data being written over them. The release only holds the pools weakly, as the manager may be destroyed before it runs, in which case there is nothing left to free the ranges in
+void GeometryManager::remove(const MeshGeometry& geometry)
+{
+	GpuResources::defer([weakPools{std::weak_ptr<std::vector<Pool>>{pools_}}, poolIndex{geometry.Pool}, vertexBytes{geometry.VertexBytes}, indexBytes{geometry.IndexBytes}]
+	{
+		const auto pools{weakPools.lock()};
+		if (!pools)
+			return;
+
+		auto& pool{(*pools)[poolIndex]};
+		release(pool.FreeVertices, pool.VertexEnd, vertexBytes);
+		release(pool.FreeIndices, pool.IndexEnd, indexBytes);
+
+		pool.VertexBytes -= vertexBytes.Size;
+		pool.IndexBytes -= indexBytes.Size;
+	});
+}
+
+// Swapping with empty vectors releases their storage, which clear alone doesn't
+void GeometryManager::releaseScratch()
+{
+	std::vector<unsigned char>{}.swap(vertexData_);
+	std::vector<unsigned char>{}.swap(indexData_);
+}
+
+long long GeometryManager::getVertexBytes() const
+{
+	long long bytes{0};
+	for (const auto& pool : *pools_)
+		bytes += pool.VertexBytes;
+
+	return bytes;
+}
+
+long long GeometryManager::getIndexBytes() const
+{
+	long long bytes{0};
+	for (const auto& pool : *pools_)
+		bytes += pool.IndexBytes;
+
+	return bytes;
+}
+
+long long GeometryManager::getVertexCapacity() const
+{
+	long long bytes{0};
+	for (const auto& pool : *pools_)
+		bytes += pool.VertexCapacity;
+
+	return bytes;
+}
+
+long long GeometryManager::getIndexCapacity() const
+{
+	long long bytes{0};
+	for (const auto& pool : *pools_)
+		bytes += pool.IndexCapacity;
+
+	return bytes;
+}
+
+// Pools are referred to by index, as adding a pool may move the others
+int GeometryManager::getPool(VertexLayout layout, bool shortIndices)
+{
+	for (auto i{0}; i < static_cast<int>(pools_->size()); ++i)
+	{
+		if ((*pools_)[i].Layout == layout && (*pools_)[i].ShortIndices == shortIndices)
+			return i;
+	}
+
+	auto pool{Pool{}};
+	pool.Layout = layout;
+	pool.ShortIndices = shortIndices;
+	initPool(pool);
+
+	pools_->push_back(std::move(pool));
+	return static_cast<int>(pools_->size()) - 1;
+}
+
+// Configure the vertex array with the pool's vertex layout plus the per-instance data, using separate attribute formats so buffers can be swapped without respecifying attributes
+void GeometryManager::initPool(Pool& pool)
+{
+	// Per-vertex attributes of each layout: positions, normals, texture coordinates, and tangents and bitangents where stored
+	const Attribute fullAttributes[]
+	{
+		{0, 3, GL_FLOAT, false, offsetof(Vertex, Position)},
+		{1, 3, GL_FLOAT, false, offsetof(Vertex, Normal)},
+		{2, 2, GL_FLOAT, false, offsetof(Vertex, TexCoords)},
+		{3, 3, GL_FLOAT, false, offsetof(Vertex, Tangent)},
+		{4, 3, GL_FLOAT, false, offsetof(Vertex, Bitangent)}
+	};
+
+	const Attribute packedAttributes[]
+	{
+		{0, 3, GL_FLOAT, false, offsetof(PackedTangentVertex, Position)},
+		{1, 4, GL_INT_2_10_10_10_REV, true, offsetof(PackedTangentVertex, Normal)},
+		{2, 2, GL_HALF_FLOAT, false, offsetof(PackedTangentVertex, TexCoords)},
+		{3, 4, GL_INT_2_10_10_10_REV, true, offsetof(PackedTangentVertex, Tangent)}
+	};
+
+	const Attribute* attributes{fullAttributes};
+	auto attributeCount{static_cast<int>(std::size(fullAttributes))};
+	pool.VertexStride = getVertexStride(pool.Layout);
+
+	if (pool.Layout == VertexLayout::PACKED)
+	{
+		// Packed vertices without tangents share the tangent layout's leading attributes
+		attributes = packedAttributes;
+		attributeCount = 3;
+	}
+	else if (pool.Layout == VertexLayout::PACKED_TANGENTS)
+	{
+		attributes = packedAttributes;
+		attributeCount = static_cast<int>(std::size(packedAttributes));
+	}
+
+	pool.IndexSize = pool.ShortIndices ? sizeof(std::uint16_t) : sizeof(unsigned int);
+	pool.VertexCapacity = initialVertexCapacity;
+	pool.IndexCapacity = initialIndexCapacity;
+
+	unsigned int vertexBuffer{};
+	glCreateBuffers(1, &vertexBuffer);
+	glNamedBufferData(vertexBuffer, static_cast<GLsizeiptr>(pool.VertexCapacity), nullptr, GL_STATIC_DRAW);
+	pool.VertexBuffer = BufferHandle{vertexBuffer, pool.VertexCapacity};
+
+	unsigned int indexBuffer{};
+	glCreateBuffers(1, &indexBuffer);
+	glNamedBufferData(indexBuffer, static_cast<GLsizeiptr>(pool.IndexCapacity), nullptr, GL_STATIC_DRAW);
+	pool.IndexBuffer = BufferHandle{indexBuffer, pool.IndexCapacity};
+
+	unsigned int vertexArray{};
+	glCreateVertexArrays(1, &vertexArray);
+	pool.Vao = VertexArrayHandle{vertexArray};
+
+	const auto vao{pool.Vao.get()};
+	glVertexArrayVertexBuffer(vao, vertexBinding, vertexBuffer, 0, pool.VertexStride);
+	glVertexArrayElementBuffer(vao, indexBuffer);
+
+	for (auto i{0}; i < attributeCount; ++i)
+	{
+		const auto& attribute{attributes[i]};
+		glEnableVertexArrayAttrib(vao, attribute.Location);
+		glVertexArrayAttribFormat(vao, attribute.Location, attribute.Size, attribute.Type, attribute.Normalised ? GL_TRUE : GL_FALSE, attribute.Offset);
+		glVertexArrayAttribBinding(vao, attribute.Location, vertexBinding);
+	}
+
+	// Per-instance model and normal matrices, one column per attribute, advancing once per instance. The buffer is attached when drawing, as it is rewritten every frame
+	for (unsigned int column{0}; column < 4; ++column)
+	{
+		glEnableVertexArrayAttrib(vao, InstanceModelLocation + column);
+		glVertexArrayAttribFormat(vao, InstanceModelLocation + column, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, Model) + column * sizeof(glm::vec4));
+		glVertexArrayAttribBinding(vao, InstanceModelLocation + column, InstanceBinding);
+	}
+
+	for (unsigned int column{0}; column < 3; ++column)
+	{
+		glEnableVertexArrayAttrib(vao, InstanceNormalLocation + column);
+		glVertexArrayAttribFormat(vao, InstanceNormalLocation + column, 3, GL_FLOAT, GL_FALSE, offsetof(InstanceData, Normal) + column * sizeof(glm::vec3));
+		glVertexArrayAttribBinding(vao, InstanceNormalLocation + column, InstanceBinding);
+	}
+	glVertexArrayBindingDivisor(vao, InstanceBinding, 1);
+}
+
+void GeometryManager::packVertices(const std::vector<Vertex>& vertices, VertexLayout layout)
+{
+	vertexData_.clear();
+
+	if (layout == VertexLayout::FULL)
+	{
+		vertexData_.resize(vertices.size() * sizeof(Vertex));
+		std::memcpy(vertexData_.data(), vertices.data(), vertexData_.size());
+
+		return;
+	}
+
+	const auto stride{layout == VertexLayout::PACKED_TANGENTS ? sizeof(PackedTangentVertex) : sizeof(PackedVertex)};
+	vertexData_.resize(vertices.size() * stride);
+
+	for (std::size_t i{0}; i < vertices.size(); ++i)
+	{
+		const auto& vertex{vertices[i]};
+
+		auto packed{PackedTangentVertex{}};
+		packed.Position = vertex.Position;
+		packed.Normal = glm::packSnorm3x10_1x2(glm::vec4{vertex.Normal, 0.0f});
+		packed.TexCoords = glm::packHalf2x16(vertex.TexCoords);
+
+		// The bitangent is either the cross product of the normal and tangent, or its negation, so only the sign needs storing
+		const auto handedness{glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f};
+		packed.Tangent = glm::packSnorm3x10_1x2(glm::vec4{vertex.Tangent, handedness});
+
+		// Packed layouts share their leading members, so vertices without tangents are a prefix of the full packed vertex
+		std::memcpy(&vertexData_[i * stride], &packed, stride);
+	}
+}
+
+// Indices are appended to those already packed, so several levels of detail can be uploaded together
+void GeometryManager::packIndices(const std::vector<unsigned int>& indices, bool shortIndices)
+{
+	const auto offset{indexData_.size()};
+
+	if (!shortIndices)
+	{
+		indexData_.resize(offset + indices.size() * sizeof(unsigned int));
+		std::memcpy(indexData_.data() + offset, indices.data(), indices.size() * sizeof(unsigned int));
+
+		return;
+	}
+
+	indexData_.resize(offset + indices.size() * sizeof(std::uint16_t));
+	for (std::size_t i{0}; i < indices.size(); ++i)
+	{
+		const auto index{static_cast<std::uint16_t>(indices[i])};
+		std::memcpy(&indexData_[offset + i * sizeof(std::uint16_t)], &index, sizeof(std::uint16_t));
+	}
+}
+
+// First fit keeps allocation simple, and meshes within a level are loaded and unloaded together, so the free ranges rarely fragment
+long long GeometryManager::allocate(std::vector<ByteRange>& freeRanges, long long& end, long long size)
+{
+	for (auto range{freeRanges.begin()}; range != freeRanges.end(); ++range)
+	{
+		if (range->Size < size)
+			continue;
+
+		const auto offset{range->Offset};
+		range->Offset += size;
+		range->Size -= size;
+		if (range->Size == 0)
+			freeRanges.erase(range);
+
+		return offset;
+	}
+
+	const auto offset{end};
+	end += size;
+
+	return offset;
+}
+
+void GeometryManager::release(std::vector<ByteRange>& freeRanges, long long& end, const ByteRange& range)
+{
+	if (range.Size == 0)
+		return;
+
+	auto next{std::lower_bound(freeRanges.begin(), freeRanges.end(), range.Offset, [](const ByteRange& free, long long offset)
+	{
+		return free.Offset < offset;
+	})};
+
+	auto merged{range};
+
+	// Absorb the free ranges directly before and after the released one
+	if (next != freeRanges.end() && merged.Offset + merged.Size == next->Offset)
+	{
+		merged.Size += next->Size;
+		next = freeRanges.erase(next);
+	}
+
+	if (next != freeRanges.begin())
+	{
+		const auto previous{std::prev(next)};
+		if (previous->Offset + previous->Size == merged.Offset)
+		{
+			merged.Offset = previous->Offset;
+			merged.Size += previous->Size;
+			next = freeRanges.erase(previous);
+		}
+	}
+
+	// Space at the end of the buffer is used by bumping the end, so isn't kept as a free range
+	if (merged.Offset + merged.Size == end)
+	{
+		end = merged.Offset;
+		return;
+	}
+
+	freeRanges.insert(next, merged);
+}
+
+// The old buffer is released rather than deleted, as draws issued before growing may still read it
+void GeometryManager::grow(BufferHandle& buffer, long long usedBytes, long long capacityBytes)
+{
+	unsigned int grown{};
+	glCreateBuffers(1, &grown);
+	glNamedBufferData(grown, static_cast<GLsizeiptr>(capacityBytes), nullptr, GL_STATIC_DRAW);
+
+	if (usedBytes > 0)
+		glCopyNamedBufferSubData(buffer.get(), grown, 0, 0, static_cast<GLsizeiptr>(usedBytes));
+
+	buffer = BufferHandle{grown, capacityBytes};
+}
+
+GeometryAllocation::GeometryAllocation() : manager_{nullptr}, geometry_{}
+{
+}
+
+GeometryAllocation::GeometryAllocation(GeometryManager& manager, MeshGeometry geometry) : manager_{&manager}, geometry_{std::move(geometry)}
+{
+}
+
+GeometryAllocation::~GeometryAllocation()
+{
+	reset();
+}
+
+GeometryAllocation::GeometryAllocation(GeometryAllocation&& other) noexcept : manager_{other.manager_}, geometry_{std::move(other.geometry_)}
+{
+	other.manager_ = nullptr;
+}
+
+GeometryAllocation& GeometryAllocation::operator=(GeometryAllocation&& other) noexcept
+{
+	if (this != &other)
+	{
+		reset();
+
+		manager_ = other.manager_;
+		geometry_ = std::move(other.geometry_);
+		other.manager_ = nullptr;
+	}
+
+	return *this;
+}
+
+void GeometryAllocation::reset()
+{
+	if (!manager_)
+		return;
+
+	manager_->remove(geometry_);
+	manager_ = nullptr;
+	geometry_ = MeshGeometry{};
+}
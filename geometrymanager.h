@@ -0,0 +1,223 @@
+#pragma once
+
+#include "gpuresource.h"
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct Vertex;
+
+// Per-instance data read by the vertex shader: the model matrix, and the matrix transforming normals into world space
+struct InstanceData
+{
+	glm::mat4 Model{};
+	glm::mat3 Normal{};
+};
+
+// Vertex as stored in GPU buffers when packing is enabled (20 bytes): normals as signed normalised 10:10:10:2 and texture coordinates as half floats
+struct PackedVertex
+{
+	glm::vec3 Position{};
+	std::uint32_t Normal{};
+	std::uint32_t TexCoords{};
+};
+
+// Packed vertex with a tangent for normal mapping (24 bytes). The bitangent is reconstructed from the normal and tangent, with the tangent's 2-bit w component giving its sign
+struct PackedTangentVertex
+{
+	glm::vec3 Position{};
+	std::uint32_t Normal{};
+	std::uint32_t TexCoords{};
+	std::uint32_t Tangent{};
+};
+
+// How vertices are stored in GPU buffers. FULL keeps the 56 byte Vertex as is; PACKED stores PackedVertex, or PackedTangentVertex for meshes that need tangents
+enum class VertexFormat
+{
+	FULL,
+	PACKED
+};
+
+// Layout of a stored vertex: Vertex, PackedVertex, or PackedTangentVertex. Values are written to baked mesh files, so must not change
+enum class VertexLayout
+{
+	FULL,
+	PACKED,
+	PACKED_TANGENTS
+};
+
+// Range of a mesh's indices within a pool's index buffer
+struct IndexRange
+{
+	int FirstIndex{};
+	int IndexCount{};
+};
+
+// Range of bytes within a buffer
+struct ByteRange
+{
+	long long Offset{};
+	long long Size{};
+};
+
+// Location of a mesh's data within the shared geometry buffers, in the form needed by indirect draw commands. Levels of detail share the mesh's vertices, each having its own range of indices, with level zero being full detail
+struct MeshGeometry
+{
+	unsigned int Vao{};
+	unsigned int IndexType{};
+	int BaseVertex{};
+	std::vector<IndexRange> Lods{};
+
+	// Pool the data was added to, and the bytes it occupies in the pool's buffers, for removing it again
+	int Pool{};
+	ByteRange VertexBytes{};
+	ByteRange IndexBytes{};
+};
+
+// Mesh data already converted to a stored layout and index size, pointing into memory owned elsewhere, e.g., a mapped baked mesh file. Levels of detail are ranges of the indices, counted from the start of the index data
+struct PackedGeometry
+{
+	VertexLayout Layout{};
+	bool ShortIndices{};
+	const void* VertexData{};
+	long long VertexBytes{};
+	const void* IndexData{};
+	long long IndexBytes{};
+	std::vector<IndexRange> Lods{};
+};
+
+class GeometryManager;
+
+// Move-only owner of a mesh's data in the shared geometry buffers, removing it from the buffers when destroyed. The manager must outlive every allocation made from it
+class GeometryAllocation
+{
+public:
+	GeometryAllocation();
+	GeometryAllocation(GeometryManager& manager, MeshGeometry geometry);
+	~GeometryAllocation();
+
+	GeometryAllocation(const GeometryAllocation&) = delete;
+	GeometryAllocation& operator=(const GeometryAllocation&) = delete;
+
+	GeometryAllocation(GeometryAllocation&& other) noexcept;
+	GeometryAllocation& operator=(GeometryAllocation&& other) noexcept;
+
+	const MeshGeometry& get() const
+	{
+		return geometry_;
+	}
+
+	// Remove the data from the buffers now rather than when the allocation is destroyed
+	void reset();
+
+private:
+	GeometryManager* manager_;
+	MeshGeometry geometry_;
+};
+
+// Class owning the vertex and index buffers that all meshes are suballocated from. Meshes are grouped into pools by vertex layout and index size, each pool having one vertex array describing its buffers, so draws within a pool can be combined into one multi-draw call. Buffers grow as meshes are added, keeping their existing contents, and space freed by removed meshes is reused by later ones, so levels can be streamed in and out without the buffers growing each time.
+class GeometryManager
+{
+public:
+	explicit GeometryManager(VertexFormat format = VertexFormat::PACKED);
+
+	// Allocations refer to the manager they were made from, so it can't be copied
+	GeometryManager(const GeometryManager&) = delete;
+	GeometryManager& operator=(const GeometryManager&) = delete;
+
+	// Copy a mesh's vertices and the indices of each of its levels of detail into the shared buffers, returning an owner of where they were placed. Tangents are only stored if needed, e.g., for normal mapping. Meshes with up to MaxShortIndexVertices vertices use 16-bit indices
+	GeometryAllocation add(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, bool needsTangents);
+
+	// Copy mesh data that is already packed straight into the shared buffers, with no conversion or copy on the CPU. Its layout should be one getLayout returns, as the pool for another layout would use a different vertex format than the rest of the game's meshes
+	GeometryAllocation add(const PackedGeometry& packed);
+
+	// Convert a mesh's vertices and the indices of each of its levels of detail into the form add stores them in, without uploading them, e.g., to bake them to a file. The result points into scratch storage, so is only valid until the next call to pack or add
+	PackedGeometry pack(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, bool needsTangents);
+
+	// Get the layout vertices are stored in, given whether tangents are needed. Safe to call from any thread, as the format never changes
+	VertexLayout getLayout(bool needsTangents) const;
+
+	// Size of a vertex stored in the layout, in bytes
+	static int getVertexStride(VertexLayout layout);
+
+	// Free the space a mesh's data occupies. The space isn't reused until the GPU has finished any draws already issued that read it, and is never freed if the manager is destroyed first
+	void remove(const MeshGeometry& geometry);
+
+	// Free the scratch storage meshes are converted in before upload. It is kept between meshes so loading doesn't reallocate it each time, so should be released once loading is done
+	void releaseScratch();
+
+	// Total size of the vertex and index data currently stored, in bytes
+	long long getVertexBytes() const;
+	long long getIndexBytes() const;
+
+	// Total size of the vertex and index buffers, including space not yet used or freed by removed meshes, in bytes
+	long long getVertexCapacity() const;
+	long long getIndexCapacity() const;
+
+	// Largest vertex count stored with 16-bit indices, each vertex then being addressable by one
+	static constexpr int MaxShortIndexVertices{65535};
+
+	// Vertex attribute location of the per-instance model matrix, which occupies four consecutive locations (one per column)
+	static constexpr unsigned int InstanceModelLocation{5};
+
+	// Vertex attribute location of the per-instance normal matrix, which occupies three consecutive locations (one per column)
+	static constexpr unsigned int InstanceNormalLocation{9};
+
+	// Vertex buffer binding point the per-instance data is read from
+	static constexpr unsigned int InstanceBinding{1};
+
+private:
+	struct Pool
+	{
+		VertexLayout Layout{};
+		bool ShortIndices{};
+		VertexArrayHandle Vao{};
+		BufferHandle VertexBuffer{};
+		BufferHandle IndexBuffer{};
+		int VertexStride{};
+		int IndexSize{};
+
+		// Bytes holding mesh data, end of the highest range ever allocated, and allocated size of each buffer
+		long long VertexBytes{};
+		long long VertexEnd{};
+		long long VertexCapacity{};
+		long long IndexBytes{};
+		long long IndexEnd{};
+		long long IndexCapacity{};
+
+		// Unused ranges below the end of each buffer's allocated ranges, sorted by offset with no two adjacent
+		std::vector<ByteRange> FreeVertices{};
+		std::vector<ByteRange> FreeIndices{};
+	};
+
+	VertexFormat format_;
+
+	// Shared with deferred removals, which hold it weakly so they can tell whether the manager still exists
+	std::shared_ptr<std::vector<Pool>> pools_;
+
+	// Scratch storage for vertices and indices converted to their stored formats
+	std::vector<unsigned char> vertexData_;
+	std::vector<unsigned char> indexData_;
+
+	// Get the index of the pool for the layout and index size, creating it if it doesn't exist yet
+	int getPool(VertexLayout layout, bool shortIndices);
+
+	// Create the pool's buffers and configure its vertex array. Done on first use, as there is no OpenGL context when the manager is constructed
+	static void initPool(Pool& pool);
+
+	// Convert vertices and indices into the layout and index size stored in the pool
+	void packVertices(const std::vector<Vertex>& vertices, VertexLayout layout);
+	void packIndices(const std::vector<unsigned int>& indices, bool shortIndices);
+
+	// Take a range of size bytes from the free ranges, or from the end of the buffer if none is large enough
+	static long long allocate(std::vector<ByteRange>& freeRanges, long long& end, long long size);
+
+	// Return a range to the free ranges, merging it with its neighbours, and pulling the end back if it was the last range
+	static void release(std::vector<ByteRange>& freeRanges, long long& end, const ByteRange& range);
+
+	// Replace a buffer with a larger one holding the same used contents
+	static void grow(BufferHandle& buffer, long long usedBytes, long long capacityBytes);
+};
@@ -0,0 +1,148 @@
+#include "gpuresource.h"
+#include <glad/glad.h>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Releases deferred during one frame, run once the fence inserted after the frame has signalled
+	struct FencedReleases
+	{
+		GLsync Fence{};
+		std::vector<std::function<void()>> Releases{};
+	};
+
+	struct ResourceState
+	{
+		std::vector<std::function<void()>> Deferred{};
+		std::deque<FencedReleases> Fenced{};
+		long long Bytes[static_cast<int>(GpuResourceType::COUNT)]{};
+		int Counts[static_cast<int>(GpuResourceType::COUNT)]{};
+		bool Closed{};
+	};
+
+	// Handles may belong to globals destroyed after this file's statics would be, so the state is created on first use and deliberately never destroyed
+	ResourceState& getState()
+	{
+		static auto* state{new ResourceState{}};
+		return *state;
+	}
+
+	void runReleases(std::vector<std::function<void()>>& releases)
+	{
+		for (auto& release : releases)
+			release();
+
+		releases.clear();
+	}
+}
+
+void GpuResources::defer(std::function<void()> release)
+{
+	auto& state{getState()};
+	if (state.Closed)
+		return;
+
+	state.Deferred.push_back(std::move(release));
+}
+
+// Fences signal in the order they were inserted, so collection stops at the first unsignalled fence
+void GpuResources::collect()
+{
+	auto& state{getState()};
+	if (state.Closed)
+		return;
+
+	if (!state.Deferred.empty())
+	{
+		state.Fenced.push_back(FencedReleases{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(state.Deferred)});
+		state.Deferred.clear();
+	}
+
+	while (!state.Fenced.empty())
+	{
+		auto& front{state.Fenced.front()};
+
+		// A timeout of zero only polls the fence
+		const auto status{glClientWaitSync(front.Fence, 0, 0)};
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			break;
+
+		glDeleteSync(front.Fence);
+		runReleases(front.Releases);
+		state.Fenced.pop_front();
+	}
+}
+
+void GpuResources::shutdown()
+{
+	auto& state{getState()};
+	if (state.Closed)
+		return;
+
+	glFinish();
+
+	for (auto& fenced : state.Fenced)
+	{
+		glDeleteSync(fenced.Fence);
+		runReleases(fenced.Releases);
+	}
+	state.Fenced.clear();
+
+	runReleases(state.Deferred);
+
+	state.Closed = true;
+}
+
+void GpuResources::track(GpuResourceType type, long long bytes, int count)
+{
+	auto& state{getState()};
+	state.Bytes[static_cast<int>(type)] += bytes;
+	state.Counts[static_cast<int>(type)] += count;
+}
+
+long long GpuResources::getBytes(GpuResourceType type)
+{
+	return getState().Bytes[static_cast<int>(type)];
+}
+
+int GpuResources::getCount(GpuResourceType type)
+{
+	return getState().Counts[static_cast<int>(type)];
+}
+
+int GpuResources::getPendingCount()
+{
+	const auto& state{getState()};
+
+	auto count{static_cast<int>(state.Deferred.size())};
+	for (const auto& fenced : state.Fenced)
+		count += static_cast<int>(fenced.Releases.size());
+
+	return count;
+}
+
+template <>
+void GpuHandle<GpuResourceType::BUFFER>::destroy(unsigned int id)
+{
+	glDeleteBuffers(1, &id);
+}
+
+template <>
+void GpuHandle<GpuResourceType::VERTEX_ARRAY>::destroy(unsigned int id)
+{
+	glDeleteVertexArrays(1, &id);
+}
+
+template <>
+void GpuHandle<GpuResourceType::TEXTURE>::destroy(unsigned int id)
+{
+	glDeleteTextures(1, &id);
+}
+
+template <>
+void GpuHandle<GpuResourceType::PROGRAM>::destroy(unsigned int id)
+{
+	glDeleteProgram(id);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <functional>
+
+// Kinds of OpenGL object whose memory and number are tracked
+enum class GpuResourceType
+{
+	BUFFER,
+	VERTEX_ARRAY,
+	TEXTURE,
+	PROGRAM,
+	COUNT
+};
+
+// Class deferring the release of GPU objects until the GPU has finished with them, and keeping totals of the objects alive and bytes allocated for each type. Releases deferred during a frame are fenced together when the frame is collected, and run once a later collect finds the fence signalled, so releasing never stalls the CPU waiting for the GPU.
+class GpuResources
+{
+public:
+	// Run release once the GPU has finished every command issued up to the end of the current frame
+	static void defer(std::function<void()> release);
+
+	// Fence the releases deferred since the last collect, then run those whose fences have signalled. Call once per frame after swapping buffers
+	static void collect();
+
+	// Wait for the GPU and run every pending release, then stop accepting releases. Call before the OpenGL context is destroyed, as objects released afterwards are freed with the context instead
+	static void shutdown();
+
+	// Adjust the totals for a type by a change in bytes and objects
+	static void track(GpuResourceType type, long long bytes, int count);
+
+	static long long getBytes(GpuResourceType type);
+	static int getCount(GpuResourceType type);
+
+	// Number of releases waiting for the GPU
+	static int getPendingCount();
+};
+
+// Move-only owner of an OpenGL object, with the bytes it holds counted towards its type's total. The object is released through GpuResources when the handle is reset or destroyed, so a handle can be dropped while draws using the object are still in flight.
+template <GpuResourceType Type>
+class GpuHandle
+{
+public:
+	GpuHandle() : id_{0}, bytes_{0}
+	{
+	}
+
+	// Take ownership of an object created by the caller
+	explicit GpuHandle(unsigned int id, long long bytes = 0) : id_{id}, bytes_{bytes}
+	{
+		if (id_ != 0)
+			GpuResources::track(Type, bytes_, 1);
+	}
+
+	~GpuHandle()
+	{
+		reset();
+	}
+
+	GpuHandle(const GpuHandle&) = delete;
+	GpuHandle& operator=(const GpuHandle&) = delete;
+
+	GpuHandle(GpuHandle&& other) noexcept : id_{other.id_}, bytes_{other.bytes_}
+	{
+		other.id_ = 0;
+		other.bytes_ = 0;
+	}
+
+	GpuHandle& operator=(GpuHandle&& other) noexcept
+	{
+		if (this != &other)
+		{
+			reset();
+
+			id_ = other.id_;
+			bytes_ = other.bytes_;
+			other.id_ = 0;
+			other.bytes_ = 0;
+		}
+
+		return *this;
+	}
+
+	unsigned int get() const
+	{
+		return id_;
+	}
+
+	long long getBytes() const
+	{
+		return bytes_;
+	}
+
+	// Record that the object's storage has been reallocated with a new size
+	void setBytes(long long bytes)
+	{
+		if (id_ != 0)
+			GpuResources::track(Type, bytes - bytes_, 0);
+
+		bytes_ = bytes;
+	}
+
+	// Release the object, if any. Its bytes stay counted until it is actually deleted
+	void reset()
+	{
+		if (id_ == 0)
+			return;
+
+		const auto id{id_};
+		const auto bytes{bytes_};
+		id_ = 0;
+		bytes_ = 0;
+
+		GpuResources::defer([id, bytes]
+		{
+			destroy(id);
+			GpuResources::track(Type, -bytes, -1);
+		});
+	}
+
+private:
+	unsigned int id_;
+	long long bytes_;
+
+	// Delete the object with the OpenGL call for its type
+	static void destroy(unsigned int id);
+};
+
+template <> void GpuHandle<GpuResourceType::BUFFER>::destroy(unsigned int id);
+template <> void GpuHandle<GpuResourceType::VERTEX_ARRAY>::destroy(unsigned int id);
+template <> void GpuHandle<GpuResourceType::TEXTURE>::destroy(unsigned int id);
+template <> void GpuHandle<GpuResourceType::PROGRAM>::destroy(unsigned int id);
+
+using BufferHandle = GpuHandle<GpuResourceType::BUFFER>;
+using VertexArrayHandle = GpuHandle<GpuResourceType::VERTEX_ARRAY>;
+using TextureHandle = GpuHandle<GpuResourceType::TEXTURE>;
+using ProgramHandle = GpuHandle<GpuResourceType::PROGRAM>;
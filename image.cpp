@@ -0,0 +1,16 @@
+#include "image.h"
+#include "stb_image.h"
+
+void ImageDataDeleter::operator()(unsigned char* data) const
+{
+	stbi_image_free(data);
+}
+
+// The decoder keeps no state between calls other than settings made once at startup, so decoding is safe on several threads at once
+DecodedImage decodeImage(const std::string& path)
+{
+	DecodedImage image{};
+	image.Data.reset(stbi_load(path.c_str(), &image.Width, &image.Height, &image.Components, 0));
+
+	return image;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+// Frees pixel data allocated by the image decoder
+struct ImageDataDeleter
+{
+	void operator()(unsigned char* data) const;
+};
+
+// Image decoded from file into 8-bit channels with no padding between rows. Rows start from the bottom of the image, as images are flipped on load (see main)
+struct DecodedImage
+{
+	int Width{};
+	int Height{};
+	int Components{};
+	std::unique_ptr<unsigned char, ImageDataDeleter> Data{};
+};
+
+// Decode the image file at path, keeping its own number of channels. Data is null if the file couldn't be read or decoded. Needs no OpenGL context, so can run on any thread
+DecodedImage decodeImage(const std::string& path);
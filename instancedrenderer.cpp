@@ -0,0 +1,242 @@
+#include "instancedrenderer.h"
+#include "model.h"
+#include "shader.h"
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+	// Screen size, as a fraction of the screen's height, below which each coarser level of detail is used
+	constexpr float lodScreenSizes[]{0.25f, 0.12f, 0.06f};
+
+	// Fraction a screen size must pass a threshold by before the level of detail changes
+	constexpr auto lodHysteresis{0.1f};
+
+	// Get the level of detail for a screen size, ignoring the current level
+	int getLodForScreenSize(float screenSize)
+	{
+		auto lod{0};
+		while (lod < static_cast<int>(std::size(lodScreenSizes)) && screenSize < lodScreenSizes[lod])
+			++lod;
+
+		return lod;
+	}
+
+	// Get the largest scale the transform applies along any axis
+	float getMaxScale(const glm::mat4& transform)
+	{
+		return std::max({glm::length(glm::vec3{transform[0]}), glm::length(glm::vec3{transform[1]}), glm::length(glm::vec3{transform[2]})});
+	}
+}
+
+InstancedRenderer::InstancedRenderer() : batches_{}, batchIndices_{}, queue_{}, instanceData_{}, lodRanges_{}, instanceBuffer_{}, cameraPosition_{0.0f}, projectionScale_{1.0f}, instanceBounds_{}, visibleInstances_{}, visibleCount_{0}, culledCount_{0}, occlusion_{nullptr}, pendingOccludedCount_{0}, occludedCount_{0}
+{
+}
+
+void InstancedRenderer::setCamera(const glm::vec3& position, float projectionScale)
+{
+	cameraPosition_ = position;
+	projectionScale_ = projectionScale;
+}
+
+// The projected diameter of the model's bounding sphere as a fraction of the screen height is approximately radius * projectionScale / distance
+int InstancedRenderer::selectLod(const Model& model, const glm::mat4& transform, int currentLod) const
+{
+	const auto& bounds{model.getBounds()};
+	const auto centre{glm::vec3{transform * glm::vec4{bounds.Centre, 1.0f}}};
+	const auto radius{bounds.Radius * getMaxScale(transform)};
+
+	// Inside the sphere the model covers the screen
+	const auto distance{glm::distance(centre, cameraPosition_)};
+	if (distance <= radius)
+		return 0;
+
+	const auto screenSize{radius * projectionScale_ / distance};
+
+	// Only move to a coarser level once the instance is clearly smaller than the threshold, and back once it is clearly larger
+	auto lod{std::clamp(currentLod, 0, model.getLodCount() - 1)};
+	const auto coarser{getLodForScreenSize(screenSize * (1.0f + lodHysteresis))};
+	const auto finer{getLodForScreenSize(screenSize * (1.0f - lodHysteresis))};
+	if (coarser > lod)
+		lod = coarser;
+	else if (finer < lod)
+		lod = finer;
+
+	return std::min(lod, model.getLodCount() - 1);
+}
+
+void InstancedRenderer::setOcclusionCuller(const OcclusionCuller* occlusion)
+{
+	occlusion_ = occlusion;
+}
+
+bool InstancedRenderer::isOccluded(const glm::vec3& min, const glm::vec3& max)
+{
+	if (!occlusion_ || !occlusion_->isOccluded(min, max))
+		return false;
+
+	++pendingOccludedCount_;
+
+	return true;
+}
+
+// Add the instance to the batch for its model and shader, creating the batch if this combination hasn't been seen before
+void InstancedRenderer::submit(const Model& model, const Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix, int lod)
+{
+	const auto key{BatchKey{&model, shader.getId()}};
+
+	auto found{batchIndices_.find(key)};
+	if (found == batchIndices_.end())
+	{
+		found = batchIndices_.emplace(key, static_cast<int>(batches_.size())).first;
+		batches_.emplace_back();
+		batches_.back().Key = key;
+	}
+
+	auto& batch{batches_[found->second]};
+	batch.BatchModel = &model;
+	batch.BatchShader = &shader;
+	batch.Instances.push_back(InstanceData{transform, normalMatrix});
+	batch.Lods.push_back(lod);
+}
+
+void InstancedRenderer::flush(const Frustum& frustum)
+{
+	// Buffer can't be created until there is an OpenGL context, so create it on first use
+	if (instanceBuffer_.get() == 0)
+	{
+		unsigned int buffer{};
+		glGenBuffers(1, &buffer);
+		instanceBuffer_ = BufferHandle{buffer};
+	}
+
+	// Transform each model's bounding sphere into world space, scaling the radius by the largest axis scale so the sphere still encloses the model
+	instanceBounds_.clear();
+	for (const auto& batch : batches_)
+	{
+		// Batches with no instances this frame hold no model, see below
+		if (batch.Instances.empty())
+			continue;
+
+		const auto& bounds{batch.BatchModel->getBounds()};
+		for (const auto& instance : batch.Instances)
+		{
+			const auto& transform{instance.Model};
+			const auto centre{glm::vec3{transform * glm::vec4{bounds.Centre, 1.0f}}};
+			instanceBounds_.add(centre, bounds.Radius * getMaxScale(transform));
+		}
+	}
+
+	// Test every instance in one batch, so the SIMD paths are used regardless of how instances are split between models
+	visibleInstances_.clear();
+	frustum.cullSpheres(instanceBounds_, visibleInstances_);
+
+	visibleCount_ = static_cast<int>(visibleInstances_.size());
+	culledCount_ = instanceBounds_.size() - visibleCount_;
+	occludedCount_ = pendingOccludedCount_;
+	pendingOccludedCount_ = 0;
+
+	// Gather the data of visible instances into one array, so they can be uploaded in one go. Visible indices are ascending, so they are consumed in batch order
+	instanceData_.clear();
+	lodRanges_.clear();
+	auto batchStart{0};
+	auto next{visibleInstances_.cbegin()};
+	for (auto& batch : batches_)
+	{
+		const auto batchEnd{batchStart + static_cast<int>(batch.Instances.size())};
+
+		// Keep only the visible instances
+		auto kept{0};
+		for (; next != visibleInstances_.cend() && *next < batchEnd; ++next)
+		{
+			batch.Instances[kept] = batch.Instances[*next - batchStart];
+			batch.Lods[kept] = batch.Lods[*next - batchStart];
+			++kept;
+		}
+
+		batch.Instances.resize(kept);
+		batch.Lods.resize(kept);
+		batchStart = batchEnd;
+
+		// Group the batch's instances by level of detail, so each level is drawn from a contiguous range of the instance buffer
+		for (auto lod{0}; kept > 0 && lod < batch.BatchModel->getLodCount(); ++lod)
+		{
+			const auto baseInstance{static_cast<int>(instanceData_.size())};
+			for (auto i{0}; i < kept; ++i)
+			{
+				if (batch.Lods[i] == lod)
+					instanceData_.push_back(batch.Instances[i]);
+			}
+
+			const auto count{static_cast<int>(instanceData_.size()) - baseInstance};
+			if (count > 0)
+				lodRanges_.push_back(LodRange{&batch, lod, baseInstance, count});
+		}
+
+		batch.Instances.clear();
+		batch.Lods.clear();
+	}
+
+	if (!instanceData_.empty())
+		draw();
+
+	// Only batches submitted to this frame have a model. The rest are dropped, so batches don't pile up as models are streamed in and out, and a model released since can't leave one behind
+	const auto unused{std::remove_if(batches_.begin(), batches_.end(), [](const Batch& batch)
+	{
+		return !batch.BatchModel;
+	})};
+
+	if (unused != batches_.end())
+	{
+		batches_.erase(unused, batches_.end());
+
+		batchIndices_.clear();
+		for (auto i{0}; i < static_cast<int>(batches_.size()); ++i)
+			batchIndices_.emplace(batches_[i].Key, i);
+	}
+
+	// Batches outlive the models and shaders submitted to them, which may be released before the next frame, so forget them until they are submitted again
+	for (auto& batch : batches_)
+	{
+		batch.BatchModel = nullptr;
+		batch.BatchShader = nullptr;
+	}
+}
+
+// Upload the data of the instances gathered by flush and queue the draws of each level of detail range
+void InstancedRenderer::draw()
+{
+	// Reallocating the buffer each frame lets the driver hand out fresh storage rather than waiting for the previous frame's draws to finish with it
+	const auto instanceBytes{static_cast<long long>(instanceData_.size() * sizeof(InstanceData))};
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer_.get());
+	glBufferData(GL_ARRAY_BUFFER, instanceBytes, instanceData_.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	instanceBuffer_.setBytes(instanceBytes);
+
+	// Each range's instances are addressed by their index into the buffer, so ranges can be drawn in any order
+	for (const auto& range : lodRanges_)
+		range.RangeBatch->BatchModel->draw(queue_, RenderPass::OPAQUE, *range.RangeBatch->BatchShader, range.Lod, range.BaseInstance, range.InstanceCount);
+
+	queue_.submit(instanceBuffer_.get());
+}
+
+const RenderQueue& InstancedRenderer::getQueue() const
+{
+	return queue_;
+}
+
+int InstancedRenderer::getVisibleCount() const
+{
+	return visibleCount_;
+}
+
+int InstancedRenderer::getCulledCount() const
+{
+	return culledCount_;
+}
+
+int InstancedRenderer::getOccludedCount() const
+{
+	return occludedCount_;
+}
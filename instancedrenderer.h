@@ -0,0 +1,95 @@
+#pragma once
+
+#include "frustum.h"
+#include "geometrymanager.h"
+#include "occlusionculler.h"
+#include "renderqueue.h"
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <map>
+#include <utility>
+#include <vector>
+
+class Model;
+class Shader;
+
+// Class that batches draws of the same Model with the same Shader, so each mesh of a model is drawn with a single instanced draw call per frame, however many objects use it. Per-instance model and normal matrices for every batch are uploaded to one shared buffer each frame, and the resulting draws are ordered by a RenderQueue.
+class InstancedRenderer
+{
+public:
+	InstancedRenderer();
+
+	// Set the camera used to measure how large instances appear on screen. projectionScale is the projection matrix's [1][1] element, the cotangent of half the vertical field of view
+	void setCamera(const glm::vec3& position, float projectionScale);
+
+	// Choose the level of detail for an instance of a model from its size on screen. The instance's current level is kept unless its size moves clearly past a threshold, so instances near a threshold don't flicker between levels
+	int selectLod(const Model& model, const glm::mat4& transform, int currentLod) const;
+
+	// Set the occlusion culler objects are tested against before being submitted, or nullptr to draw objects however hidden they are
+	void setOcclusionCuller(const OcclusionCuller* occlusion);
+
+	// Whether the world space box is hidden behind the occluders drawn this frame, in which case the object it bounds shouldn't be submitted. Hidden boxes are counted towards the culled instances
+	bool isOccluded(const glm::vec3& min, const glm::vec3& max);
+
+	// Queue an instance of a model to be drawn at the given level of detail with the given model and normal matrices
+	void submit(const Model& model, const Shader& shader, const glm::mat4& transform, const glm::mat3& normalMatrix, int lod);
+
+	// Cull queued instances outside the frustum, upload the data of those remaining and draw each batch, then clear the queue
+	void flush(const Frustum& frustum);
+
+	const RenderQueue& getQueue() const;
+
+	// Number of instances drawn and culled by the last flush, with those hidden behind occluders counted separately from those outside the frustum
+	int getVisibleCount() const;
+	int getCulledCount() const;
+	int getOccludedCount() const;
+
+private:
+	// Model and shader identifying a batch
+	using BatchKey = std::pair<const Model*, unsigned int>;
+
+	// Model and shader are only set while the batch has instances queued, as nothing keeps them alive beyond the frame they are submitted in
+	struct Batch
+	{
+		BatchKey Key{};
+		const Model* BatchModel{};
+		const Shader* BatchShader{};
+		std::vector<InstanceData> Instances{};
+		std::vector<int> Lods{};
+	};
+
+	// A contiguous range of the instance buffer drawn with one level of detail of a batch's model
+	struct LodRange
+	{
+		const Batch* RangeBatch{};
+		int Lod{};
+		int BaseInstance{};
+		int InstanceCount{};
+	};
+
+	// Batches persist between frames while they are drawn so their storage is reused, and are dropped after a frame nothing is submitted to them. Models are identified by address, as AssetManager shares one model between everything loaded from the same path, and two models loaded from the same path own separate GPU data
+	std::vector<Batch> batches_;
+	std::map<BatchKey, int> batchIndices_;
+
+	RenderQueue queue_;
+	std::vector<InstanceData> instanceData_;
+	std::vector<LodRange> lodRanges_;
+	BufferHandle instanceBuffer_;
+
+	glm::vec3 cameraPosition_;
+	float projectionScale_;
+
+	// World space bounding spheres of all queued instances, in batch order, and the indices of those passing the frustum test
+	SphereList instanceBounds_;
+	std::vector<int> visibleInstances_;
+	int visibleCount_;
+	int culledCount_;
+
+	// Objects are tested for occlusion as they are submitted, so the count for the frame being built is kept apart from the last flush's
+	const OcclusionCuller* occlusion_;
+	int pendingOccludedCount_;
+	int occludedCount_;
+
+	void draw();
+};
@@ -0,0 +1,200 @@
+#include "jobsystem.h"
+#include <algorithm>
+
+namespace
+{
+	// Index of the queue owned by the current thread -- zero for threads that aren't pool workers
+	thread_local int currentQueueIndex{0};
+
+	// Whether the job the current thread is running is background work, which chunks it splits off inherit
+	thread_local bool runningBackground{false};
+}
+
+JobSystem::JobSystem(int workerCount) : queues_{}, backgroundQueue_{}, workers_{}, wakeMutex_{}, wake_{}, queuedJobs_{0}, stopping_{false}
+{
+	const auto count{std::max(workerCount, 0)};
+
+	for (auto i{0}; i <= count; ++i)
+		queues_.push_back(std::make_unique<JobQueue>());
+
+	for (auto i{1}; i <= count; ++i)
+		workers_.emplace_back(&JobSystem::runWorker, this, i);
+}
+
+// Wake all workers and wait for them to exit
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{wakeMutex_};
+		stopping_ = true;
+	}
+	wake_.notify_all();
+
+	for (auto& worker : workers_)
+		worker.join();
+}
+
+void JobSystem::parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+	if (begin >= end)
+		return;
+
+	const auto grain{std::max(grainSize, 1)};
+
+	// Nothing to gain from splitting work that fits in a single chunk, or with no workers to share it with
+	if (workers_.empty() || end - begin <= grain)
+	{
+		for (auto chunkBegin{begin}; chunkBegin < end; chunkBegin += grain)
+			body(chunkBegin, std::min(chunkBegin + grain, end));
+
+		return;
+	}
+
+	const auto queueIndex{currentQueueIndex};
+	std::atomic<int> remaining{(end - begin + grain - 1) / grain};
+
+	for (auto chunkBegin{begin}; chunkBegin < end; chunkBegin += grain)
+	{
+		const auto chunkEnd{std::min(chunkBegin + grain, end)};
+		push(queueIndex, Job{[&body, chunkBegin, chunkEnd]() { body(chunkBegin, chunkEnd); }, &remaining, runningBackground});
+	}
+
+	// Help out until every chunk is done, rather than blocking. Background tasks are left alone, as one could run far longer than the chunks being waited for
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		if (!tryRunJob(queueIndex, false))
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::runInBackground(std::function<void()> task)
+{
+	if (workers_.empty())
+	{
+		task();
+
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{backgroundQueue_.Mutex};
+		backgroundQueue_.Jobs.push_back(Job{std::move(task), nullptr, true});
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{wakeMutex_};
+		++queuedJobs_;
+	}
+	wake_.notify_one();
+}
+
+int JobSystem::getDefaultWorkerCount()
+{
+	const auto cores{static_cast<int>(std::thread::hardware_concurrency())};
+
+	return std::max(cores - 1, 0);
+}
+
+// Run jobs until the pool is destroyed, sleeping whenever no jobs are queued
+void JobSystem::runWorker(int queueIndex)
+{
+	currentQueueIndex = queueIndex;
+
+	while (true)
+	{
+		if (tryRunJob(queueIndex, true))
+			continue;
+
+		std::unique_lock<std::mutex> lock{wakeMutex_};
+		wake_.wait(lock, [this]() { return stopping_ || queuedJobs_.load() > 0; });
+
+		if (stopping_)
+			return;
+	}
+}
+
+// Run one job from the thread's own queue, or failing that one stolen from another queue, or failing that (if allowed) a background task
+bool JobSystem::tryRunJob(int queueIndex, bool allowBackground)
+{
+	Job job{};
+	if (!pop(queueIndex, job) && !steal(queueIndex, job) && (!allowBackground || !popBackground(job)))
+		return false;
+
+	// A job may be run while the thread waits in a parallelFor of another kind, so the previous kind is restored afterwards
+	const auto wasBackground{runningBackground};
+	runningBackground = job.Background;
+	job.Task();
+	runningBackground = wasBackground;
+
+	if (job.Remaining)
+		job.Remaining->fetch_sub(1, std::memory_order_release);
+
+	return true;
+}
+
+void JobSystem::push(int queueIndex, Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock{queues_[queueIndex]->Mutex};
+		queues_[queueIndex]->Jobs.push_back(std::move(job));
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{wakeMutex_};
+		++queuedJobs_;
+	}
+	wake_.notify_one();
+}
+
+// Owners take the most recently pushed job, which is the most likely to still be in cache
+bool JobSystem::pop(int queueIndex, Job& job)
+{
+	auto& queue{*queues_[queueIndex]};
+	std::lock_guard<std::mutex> lock{queue.Mutex};
+
+	if (queue.Jobs.empty())
+		return false;
+
+	job = std::move(queue.Jobs.back());
+	queue.Jobs.pop_back();
+	--queuedJobs_;
+
+	return true;
+}
+
+// Thieves take the oldest job, which for parallelFor is the chunk furthest from what the owner is working on. Threads outside the pool leave a queue alone if its oldest job is background work, which the queue's owner or another worker will get to
+bool JobSystem::steal(int thiefIndex, Job& job)
+{
+	const auto queueCount{static_cast<int>(queues_.size())};
+
+	for (auto offset{1}; offset < queueCount; ++offset)
+	{
+		auto& queue{*queues_[(thiefIndex + offset) % queueCount]};
+		std::lock_guard<std::mutex> lock{queue.Mutex};
+
+		if (queue.Jobs.empty() || (thiefIndex == 0 && queue.Jobs.front().Background))
+			continue;
+
+		job = std::move(queue.Jobs.front());
+		queue.Jobs.pop_front();
+		--queuedJobs_;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool JobSystem::popBackground(Job& job)
+{
+	std::lock_guard<std::mutex> lock{backgroundQueue_.Mutex};
+
+	if (backgroundQueue_.Jobs.empty())
+		return false;
+
+	job = std::move(backgroundQueue_.Jobs.front());
+	backgroundQueue_.Jobs.pop_front();
+	--queuedJobs_;
+
+	return true;
+}
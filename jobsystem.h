@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Class representing a pool of worker threads that execute jobs using work stealing. Each thread owns a deque of jobs: it pushes and pops jobs at the back of its own deque, and when that runs dry it steals from the front of other threads' deques, balancing uneven work across cores. A pool with no workers runs every job inline on the calling thread, serving as a single-threaded reference mode.
+class JobSystem
+{
+public:
+	explicit JobSystem(int workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Split [begin, end) into chunks of up to grainSize and call body(chunkBegin, chunkEnd) for each chunk, returning once all chunks have finished. The calling thread executes jobs while it waits, so parallelFor can be nested inside jobs
+	void parallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+	// Queue a task to run in the background without waiting for it, e.g., loading assets. Background tasks are only run by idle workers, once they have no parallelFor chunks to run, and never by a thread waiting in parallelFor, so they never hold one up. Chunks of a parallelFor called by a background task are background work too, so are never stolen by threads outside the pool, e.g., the main thread waiting on its own parallelFor. With no workers the task runs inline before returning
+	void runInBackground(std::function<void()> task);
+
+	int getWorkerCount() const
+	{
+		return static_cast<int>(workers_.size());
+	}
+
+	// Get a worker count that leaves one core for the main thread
+	static int getDefaultWorkerCount();
+
+	// Most workers worth starting, well beyond the core count of any machine the game targets
+	static constexpr int MaxWorkerCount{64};
+
+private:
+	struct Job
+	{
+		std::function<void()> Task{};
+
+		// Counter of unfinished jobs decremented once the job has run, or null if nothing waits for the job
+		std::atomic<int>* Remaining{};
+
+		// Whether the job is a background task or a chunk of a parallelFor one called, which only workers may run
+		bool Background{};
+	};
+
+	struct JobQueue
+	{
+		std::mutex Mutex{};
+		std::deque<Job> Jobs{};
+	};
+
+	// One queue per worker, plus queue zero for threads outside of the pool (e.g., the main thread)
+	std::vector<std::unique_ptr<JobQueue>> queues_;
+
+	// Background tasks, shared by all workers and taken oldest first
+	JobQueue backgroundQueue_;
+	std::vector<std::thread> workers_;
+
+	std::mutex wakeMutex_;
+	std::condition_variable wake_;
+	std::atomic<int> queuedJobs_;
+	bool stopping_;
+
+	void runWorker(int queueIndex);
+	bool tryRunJob(int queueIndex, bool allowBackground);
+	void push(int queueIndex, Job job);
+	bool pop(int queueIndex, Job& job);
+	bool steal(int thiefIndex, Job& job);
+	bool popBackground(Job& job);
+};
@@ -1,9 +1,15 @@
 #include "main.h"
 #include "game.h"
+#include "gpuresource.h"
+#include "model.h"
 #include <GLFW/glfw3.h>
 #include "stb_image.h"
+#include <charconv>
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <string>
 
 // Constants defining viewport horizontal and vertical resolution
 constexpr auto SCREEN_WIDTH{1280};
@@ -12,9 +18,94 @@ constexpr auto SCREEN_HEIGHT{720};
 // Game instance is global to enable access by GLFW callbacks
 Game gameInstance{SCREEN_WIDTH, SCREEN_HEIGHT};
 
+namespace
+{
+	// Most simulated characters that can be requested, far more than can be updated sixty times per second
+	constexpr auto maxAgents{100000};
+
+	// Parse a command line value that must be a whole number from min to max, returning whether it was one
+	bool parseCount(const char* text, int min, int max, int& count)
+	{
+		const auto end{text + std::strlen(text)};
+		auto value{0};
+		const auto [last, error]{std::from_chars(text, end, value)};
+		if (error != std::errc{} || last != end || value < min || value > max)
+			return false;
+
+		count = value;
+
+		return true;
+	}
+
+	void printUsage()
+	{
+		std::cout << "Usage: BoundingBox [--agents <0-" << maxAgents << ">] [--threads <0-" << JobSystem::MaxWorkerCount << ">]\n"
+			<< "       BoundingBox --bake <model files>\n";
+	}
+}
+
 // Initialise GLFW and run game loop
-int main()
+int main(int argc, char* argv[])
 {
+	// Bake model files into the form loaded in their place, e.g., "BoundingBox.exe --bake media/platform/platform.obj", then exit. Baking uploads nothing, so happens before any window or context is created
+	if (argc > 1 && std::string{argv[1]} == "--bake")
+	{
+		GeometryManager geometry{};
+
+		auto result{0};
+		for (auto i{2}; i < argc; ++i)
+		{
+			if (!Model::bake(argv[i], geometry))
+				result = -1;
+		}
+
+		return result;
+	}
+
+	// Optionally simulate additional player-like characters for load testing, e.g., "BoundingBox.exe --agents 1000", and set the number of update worker threads, with "--threads 0" giving the single-threaded reference mode. Checked before any window is created, so a mistyped option exits straight away
+	for (auto i{1}; i < argc; ++i)
+	{
+		const auto option{std::string{argv[i]}};
+		const auto value{i + 1 < argc ? argv[++i] : ""};
+
+		if (option == "--agents")
+		{
+			auto agents{0};
+			if (!parseCount(value, 0, maxAgents, agents))
+			{
+				std::cout << "ERROR::MAIN::INVALID_AGENT_COUNT: " << value << "\n";
+				printUsage();
+
+				return -1;
+			}
+
+			gameInstance.spawnAgents(agents);
+		}
+		else if (option == "--threads")
+		{
+			auto threads{0};
+			if (!parseCount(value, 0, std::numeric_limits<int>::max(), threads))
+			{
+				std::cout << "ERROR::MAIN::INVALID_THREAD_COUNT: " << value << "\n";
+				printUsage();
+
+				return -1;
+			}
+
+			if (threads > JobSystem::MaxWorkerCount)
+				std::cout << "Using " << JobSystem::MaxWorkerCount << " worker threads, the most supported\n";
+
+			gameInstance.setWorkerCount(threads);
+		}
+		else
+		{
+			std::cout << "ERROR::MAIN::UNKNOWN_OPTION: " << option << "\n";
+			printUsage();
+
+			return -1;
+		}
+	}
+
 	glfwInit();
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -56,6 +147,7 @@ int main()
 	// OpenGL config
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
 	gameInstance.init();
 
@@ -95,16 +187,22 @@ int main()
 		glfwSwapBuffers(window);
 		++frames;
 
+		// Delete GPU objects released in earlier frames that the GPU has finished with
+		GpuResources::collect();
+
 		// Print rates and reset counters
 		if (glfwGetTime() - timer > 1.0)
 		{
 			++timer;
-			std::cout << "FPS: " << frames << ", Updates: " << updates << "\n";
+			std::cout << "FPS: " << frames << ", Updates: " << updates << ", Visible: " << gameInstance.getRenderer().getVisibleCount() << ", Culled: " << gameInstance.getRenderer().getCulledCount() << ", Occluded: " << gameInstance.getRenderer().getOccludedCount() << ", GPU buffers: " << GpuResources::getBytes(GpuResourceType::BUFFER) / (1024 * 1024) << " MB, GPU textures: " << GpuResources::getBytes(GpuResourceType::TEXTURE) / (1024 * 1024) << " MB\n";
 			updates = 0;
 			frames = 0;
 		}
 	}
 
+	// The game outlives the window, so its GPU objects are released with the context. Anything already released is deleted now
+	GpuResources::shutdown();
+
 	glfwDestroyWindow(window);
 
 	glfwTerminate();
@@ -0,0 +1,115 @@
+#include "mappedfile.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() : data_{nullptr}, size_{0}, mapping_{nullptr}
+{
+}
+
+// Empty files can't be mapped, so are treated the same as missing ones
+MappedFile::MappedFile(const std::string& path) : MappedFile{}
+{
+#ifdef _WIN32
+	const auto file{CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size{};
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		// The mapping keeps the file open, so the file handle itself isn't needed once the mapping exists
+		const auto mapping{CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+		if (mapping)
+		{
+			const auto view{MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)};
+			if (view)
+			{
+				data_ = static_cast<const unsigned char*>(view);
+				size_ = static_cast<std::size_t>(size.QuadPart);
+				mapping_ = mapping;
+			}
+			else
+				CloseHandle(mapping);
+		}
+	}
+
+	CloseHandle(file);
+#else
+	const auto file{open(path.c_str(), O_RDONLY)};
+	if (file < 0)
+		return;
+
+	struct stat status{};
+	if (fstat(file, &status) == 0 && status.st_size > 0)
+	{
+		const auto view{mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0)};
+		if (view != MAP_FAILED)
+		{
+			data_ = static_cast<const unsigned char*>(view);
+			size_ = static_cast<std::size_t>(status.st_size);
+		}
+	}
+
+	// Mappings stay valid after their file descriptor is closed
+	::close(file);
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept : data_{other.data_}, size_{other.size_}, mapping_{other.mapping_}
+{
+	other.data_ = nullptr;
+	other.size_ = 0;
+	other.mapping_ = nullptr;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		close();
+
+		data_ = other.data_;
+		size_ = other.size_;
+		mapping_ = other.mapping_;
+		other.data_ = nullptr;
+		other.size_ = 0;
+		other.mapping_ = nullptr;
+	}
+
+	return *this;
+}
+
+void MappedFile::close()
+{
+	if (!data_)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(data_);
+	CloseHandle(mapping_);
+#else
+	munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+
+	data_ = nullptr;
+	size_ = 0;
+	mapping_ = nullptr;
+}
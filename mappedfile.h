@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Class mapping a file read-only into memory, so its contents can be read in place without copying them into buffers of our own. Pages are only read from disk as they are touched, and stay in the OS's file cache between runs.
+class MappedFile
+{
+public:
+	MappedFile();
+
+	// Map the whole file at path. The file is empty if it couldn't be opened or mapped
+	explicit MappedFile(const std::string& path);
+
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	const unsigned char* getData() const
+	{
+		return data_;
+	}
+
+	std::size_t getSize() const
+	{
+		return size_;
+	}
+
+	bool isOpen() const
+	{
+		return data_ != nullptr;
+	}
+
+	// Unmap the file
+	void close();
+
+private:
+	const unsigned char* data_;
+	std::size_t size_;
+
+	// Handle of the file mapping object, which Windows needs keeping until the view is unmapped
+	void* mapping_;
+};
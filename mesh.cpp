@@ -1,35 +1,94 @@
 #include "mesh.h"
 
 #include <glm/matrix.hpp>
+#include <algorithm>
+#include <map>
+#include <utility>
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
-           const std::vector<Texture>& textures)
+namespace
 {
-	this->Vertices = vertices;
-	this->Indices = indices;
-	this->Textures = textures;
+	// Get the id for a set of textures, giving each distinct set a new id the first time it's seen
+	unsigned int getMaterialId(const std::vector<Texture>& textures)
+	{
+		static std::map<std::vector<unsigned int>, unsigned int> materialIds{};
+
+		auto textureIds{std::vector<unsigned int>{}};
+		for (const auto& texture : textures)
+			textureIds.push_back(texture.Id);
+
+		return materialIds.emplace(std::move(textureIds), static_cast<unsigned int>(materialIds.size()) + 1).first->second;
+	}
+}
+
+Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods,
+           const std::vector<Texture>& textures, const BoundingVolume& bounds, GeometryManager& geometry, MeshRetention retention)
+{
+	this->Retention = retention;
+	this->IndexCount = static_cast<int>(lods.front().size());
+	this->Bounds = bounds;
+	setTextures(textures);
+
+	// Upload vertices and indices to the buffers shared by all meshes. The caller's copies are all that's needed, so the mesh only copies what it is asked to keep
+	Geometry = geometry.add(vertices, lods, needsTangents(Textures));
+
+	keepData(vertices, lods);
+}
+
+Mesh::Mesh(const PackedGeometry& packed, const std::vector<Texture>& textures, const BoundingVolume& bounds, GeometryManager& geometry)
+{
+	this->Retention = MeshRetention::NONE;
+	this->IndexCount = packed.Lods.front().IndexCount;
+	this->Bounds = bounds;
+	setTextures(textures);
+
+	Geometry = geometry.add(packed);
+}
+
+void Mesh::retain(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, MeshRetention retention)
+{
+	if (retention <= Retention)
+		return;
+
+	Retention = retention;
+
+	keepData(vertices, lods);
+}
+
+// Each level of retention keeps everything the levels below it do. A proxy kept by an earlier, lower retention is reused rather than built again
+void Mesh::keepData(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods)
+{
+	if (Retention >= MeshRetention::COLLISION_PROXY && Proxy.Indices.empty())
+		Proxy = buildCollisionProxy(vertices, lods.back());
+
+	if (Retention == MeshRetention::FULL)
+	{
+		Vertices = vertices;
+		Indices = lods.front();
+	}
+}
 
-	setUpMesh();
+// Tangents are only needed for normal mapping
+bool Mesh::needsTangents(const std::vector<Texture>& textures)
+{
+	return std::any_of(textures.begin(), textures.end(), [](const Texture& texture)
+	{
+		return texture.Type == "texture_normal";
+	});
 }
 
-// Render the mesh using the provided shader and transform
-void Mesh::draw(const Shader& shader, const glm::mat4& transform) const
+void Mesh::setTextures(const std::vector<Texture>& textures)
 {
-	// First texture of each type will have the index 1
+	this->Textures = textures;
+
+	// Number textures of each type from 1, giving the sampler name they are read through and hence the unit they are bound to
 	unsigned int diffuseNr{1};
 	unsigned int specularNr{1};
 	unsigned int normalNr{1};
 	unsigned int heightNr{1};
 
-	shader.use();
-
-	// Set sampler in shader and bind texture for rendering
-	for (auto i{0}; i < Textures.size(); ++i)
+	for (const auto& texture : Textures)
 	{
-		glActiveTexture(GL_TEXTURE0 + i);
-
-		// Get texture index based on number of existing textures of its type
-		const auto name{Textures[i].Type};
+		const auto& name{texture.Type};
 		std::string number{};
 		if (name == "texture_diffuse")
 			number = std::to_string(diffuseNr++);
@@ -40,62 +99,43 @@ void Mesh::draw(const Shader& shader, const glm::mat4& transform) const
 		else if (name == "texture_height")
 			number = std::to_string(heightNr++);
 
-		shader.setUniform(name + number, i);
-
-		glBindTexture(GL_TEXTURE_2D, Textures[i].Id);
+		TextureUnits.push_back(Shader::getTextureUnit(name + number));
 	}
 
-	shader.setUniform("model", transform);
-
-	// Render the mesh
-	glBindVertexArray(VAO);
-	glDrawElements(GL_TRIANGLES, Indices.size(), GL_UNSIGNED_INT, nullptr);
-	glBindVertexArray(0);
-
-	glActiveTexture(GL_TEXTURE0);
+	MaterialId = ::getMaterialId(Textures);
 }
 
-// Configure OpenGL buffers and attribute pointers needed for drawing the mesh
-void Mesh::setUpMesh()
+// Keep only the positions of vertices the indices use, renumbering indices to match, so the proxy is as small as the coarsest level of detail rather than the full vertex array
+CollisionProxy Mesh::buildCollisionProxy(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices)
 {
-	// Generate vertex array and buffers
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
+	CollisionProxy proxy{};
+	proxy.Indices.reserve(indices.size());
 
-	// Bind VAO to store subsequent VBO and attribute pointer configuration
-	glBindVertexArray(VAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// Since structs are sequential, a pointer to struct functions like a pointer to the first element of an array, meaning it can be passed to indicate the start of the data vertex
-	glBufferData(GL_ARRAY_BUFFER, Vertices.size() * sizeof(Vertex), &Vertices[0], GL_STATIC_DRAW);
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, Indices.size() * sizeof(unsigned int), &Indices[0], GL_STATIC_DRAW);
-
-	// Configure vertex attribute pointers
-
-	constexpr auto stride{sizeof(Vertex)};
-	// Positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
-
-	// Normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, Normal)));
+	constexpr auto unassigned{~0u};
+	std::vector<unsigned int> remap(vertices.size(), unassigned);
+	for (const auto index : indices)
+	{
+		if (remap[index] == unassigned)
+		{
+			remap[index] = static_cast<unsigned int>(proxy.Positions.size());
+			proxy.Positions.push_back(vertices[index].Position);
+		}
 
-	// Texture coordinates
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, TexCoords)));
+		proxy.Indices.push_back(remap[index]);
+	}
 
-	// Vertex tangents
-	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, Tangent)));
+	return proxy;
+}
 
-	// Vertex bitangents
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(offsetof(Vertex, Bitangent)));
+// Bind textures to the units their samplers are fixed to, so no sampler uniforms need to be set
+void Mesh::bindTextures() const
+{
+	for (std::size_t i{0}; i < Textures.size(); ++i)
+	{
+		if (TextureUnits[i] < 0)
+			continue;
 
-	// Unbind VAO once configuration is finished
-	glBindVertexArray(0);
+		glActiveTexture(GL_TEXTURE0 + TextureUnits[i]);
+		glBindTexture(GL_TEXTURE_2D, Textures[i].Id);
+	}
 }
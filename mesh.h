@@ -1,5 +1,6 @@
 #pragma once
 
+#include "geometrymanager.h"
 #include "shader.h"
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
@@ -15,6 +16,31 @@ struct Vertex
 	glm::vec3 Bitangent{};
 };
 
+// Bounding box and sphere enclosing a mesh, in the mesh's local space
+struct BoundingVolume
+{
+	glm::vec3 Min{};
+	glm::vec3 Max{};
+	glm::vec3 Centre{};
+	float Radius{};
+};
+
+// CPU-side data a mesh keeps once it has been uploaded, drawing needing only what's in the GPU buffers. Ordered from least to most kept
+enum class MeshRetention
+{
+	NONE,            // Index count and bounds only
+	COLLISION_PROXY, // Also a compact triangle mesh built from the coarsest level of detail
+	FULL             // Also every vertex and full detail index, e.g., for a mesh collider or picking on the CPU
+};
+
+// Triangles of a mesh reduced to positions alone, enough for collision and ray queries
+struct CollisionProxy
+{
+	std::vector<glm::vec3> Positions{};
+	std::vector<unsigned int> Indices{};
+};
+
+// Texture used by a mesh, with Type being the sampler type, e.g., "texture_diffuse", and Path relative to the model's directory. The texture object is owned by the model the mesh belongs to, and the id is zero until it has been loaded
 struct Texture
 {
 	unsigned int Id{};
@@ -26,18 +52,96 @@ struct Texture
 class Mesh
 {
 public:
-	Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<Texture>& textures);
+	// Create a mesh from its vertices and the indices of each level of detail, the first being full detail, uploading them and keeping only what retention asks for
+	Mesh(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, const std::vector<Texture>& textures, const BoundingVolume& bounds, GeometryManager& geometry, MeshRetention retention = MeshRetention::NONE);
+
+	// Create a mesh from data already packed for upload, e.g., read from a baked model file. Only MeshRetention::NONE is possible, as packed vertices can't be turned back into the vertices retention would keep
+	Mesh(const PackedGeometry& packed, const std::vector<Texture>& textures, const BoundingVolume& bounds, GeometryManager& geometry);
+
+	// Meshes own their space in the shared geometry buffers, freeing it when destroyed, so can be moved but not copied
+	Mesh(const Mesh&) = delete;
+	Mesh& operator=(const Mesh&) = delete;
+	Mesh(Mesh&&) noexcept = default;
+	Mesh& operator=(Mesh&&) noexcept = default;
+
+	// Keep the CPU-side data retention asks for from the vertices and levels of detail the mesh was created from, for a mesh created with less retention. Nothing is uploaded, as the mesh's geometry is already on the GPU, and nothing already kept is dropped
+	void retain(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods, MeshRetention retention);
 
-	void draw(const Shader& shader, const glm::mat4& transform) const;
+	// Bind the mesh's textures to the units their samplers are fixed to
+	void bindTextures() const;
+
+	// Whether a mesh with the textures needs tangents stored with its vertices
+	static bool needsTangents(const std::vector<Texture>& textures);
+
+	// Get where the mesh's vertices and indices are stored in the shared geometry buffers
+	const MeshGeometry& getGeometry() const
+	{
+		return Geometry.get();
+	}
+
+	int getLodCount() const
+	{
+		return static_cast<int>(Geometry.get().Lods.size());
+	}
+
+	// Get the id of the mesh's set of textures. Meshes with identical texture sets share an id, starting from 1
+	unsigned int getMaterialId() const
+	{
+		return MaterialId;
+	}
+
+	const BoundingVolume& getBounds() const
+	{
+		return Bounds;
+	}
+
+	// Number of indices at full detail
+	int getIndexCount() const
+	{
+		return IndexCount;
+	}
+
+	MeshRetention getRetention() const
+	{
+		return Retention;
+	}
+
+	// Vertices and full detail indices, empty unless the mesh was created with MeshRetention::FULL
+	const std::vector<Vertex>& getVertices() const
+	{
+		return Vertices;
+	}
+
+	const std::vector<unsigned int>& getIndices() const
+	{
+		return Indices;
+	}
+
+	// Compact triangle mesh for collision queries, empty unless the mesh was created with MeshRetention::COLLISION_PROXY or more
+	const CollisionProxy& getCollisionProxy() const
+	{
+		return Proxy;
+	}
 
 private:
+	MeshRetention Retention{};
+	int IndexCount{};
 	std::vector<Vertex> Vertices{};
 	std::vector<unsigned int> Indices{};
+	CollisionProxy Proxy{};
 	std::vector<Texture> Textures{};
-	unsigned int VAO{};
 
-	unsigned int VBO{};
-	unsigned int EBO{};
+	// Texture unit each texture is bound to, see Shader::getTextureUnit
+	std::vector<int> TextureUnits{};
+	unsigned int MaterialId{};
+	BoundingVolume Bounds{};
+	GeometryAllocation Geometry{};
+
+	// Copy the CPU-side data the mesh's retention asks for from the vertices and levels of detail it was created from
+	void keepData(const std::vector<Vertex>& vertices, const std::vector<std::vector<unsigned int>>& lods);
+
+	// Store the textures and work out the units they are bound to and the material they make up
+	void setTextures(const std::vector<Texture>& textures);
 
-	void setUpMesh();
+	static CollisionProxy buildCollisionProxy(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
 };
@@ -0,0 +1,359 @@
+#include "meshoptimiser.h"
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+	// Cache size used when measuring ACMR and finding cluster boundaries, typical of the FIFO caches of real hardware
+	constexpr auto fifoCacheSize{16};
+
+	// Constants from Forsyth's paper. The modelled LRU cache is larger than hardware caches, which the paper found works well across cache sizes
+	constexpr auto lruCacheSize{32};
+	constexpr auto cacheDecayPower{1.5f};
+	constexpr auto lastTriangleScore{0.75f};
+	constexpr auto valenceBoostScale{2.0f};
+	constexpr auto valenceBoostPower{0.5f};
+
+	// Score of a vertex given its position in the simulated LRU cache (-1 if not in it) and the number of triangles still to be drawn that use it
+	float vertexScore(int cachePosition, int remainingTriangles)
+	{
+		// Vertices with no remaining triangles should never be chosen
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		auto score{0.0f};
+		if (cachePosition >= 0)
+		{
+			// Vertices of the last triangle get a fixed score, so the next triangle doesn't simply reuse its edge and create long strips
+			if (cachePosition < 3)
+				score = lastTriangleScore;
+			else
+				score = std::pow(1.0f - static_cast<float>(cachePosition - 3) / (lruCacheSize - 3), cacheDecayPower);
+		}
+
+		// Boost vertices with few remaining triangles, so lone triangles aren't left behind to be drawn later with no reuse
+		score += valenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -valenceBoostPower);
+
+		return score;
+	}
+
+	// Hash and compare vertices by their bytes, so vertices are merged only if every attribute is identical
+	struct VertexHash
+	{
+		const std::vector<Vertex>* Vertices;
+
+		std::size_t operator()(unsigned int index) const
+		{
+			// FNV-1a
+			const auto bytes{reinterpret_cast<const unsigned char*>(&(*Vertices)[index])};
+			std::size_t hash{14695981039346656037ull};
+			for (std::size_t i{0}; i < sizeof(Vertex); ++i)
+			{
+				hash ^= bytes[i];
+				hash *= 1099511628211ull;
+			}
+
+			return hash;
+		}
+	};
+
+	struct VertexEqual
+	{
+		const std::vector<Vertex>* Vertices;
+
+		bool operator()(unsigned int a, unsigned int b) const
+		{
+			return std::memcmp(&(*Vertices)[a], &(*Vertices)[b], sizeof(Vertex)) == 0;
+		}
+	};
+}
+
+MeshOptimisationStats optimiseMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool optimiseOverdraw)
+{
+	auto stats{MeshOptimisationStats{}};
+	stats.VerticesBefore = static_cast<int>(vertices.size());
+	stats.AcmrBefore = calculateAcmr(indices, stats.VerticesBefore, fifoCacheSize);
+
+	deduplicateVertices(vertices, indices);
+	optimiseVertexCache(indices, static_cast<int>(vertices.size()));
+
+	if (optimiseOverdraw)
+		::optimiseOverdraw(vertices, indices, fifoCacheSize);
+
+	// Done last, as it depends on the final triangle order
+	optimiseVertexFetch(vertices, indices);
+
+	stats.VerticesAfter = static_cast<int>(vertices.size());
+	stats.AcmrAfter = calculateAcmr(indices, stats.VerticesAfter, fifoCacheSize);
+
+	return stats;
+}
+
+void deduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::unordered_map<unsigned int, unsigned int, VertexHash, VertexEqual> uniqueVertices{vertices.size(), VertexHash{&vertices}, VertexEqual{&vertices}};
+
+	// Map each vertex to the first identical vertex, which keeps its place in the compacted array
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<Vertex> unique{};
+	unique.reserve(vertices.size());
+
+	for (unsigned int i{0}; i < vertices.size(); ++i)
+	{
+		const auto inserted{uniqueVertices.emplace(i, static_cast<unsigned int>(unique.size()))};
+		if (inserted.second)
+			unique.push_back(vertices[i]);
+
+		remap[i] = inserted.first->second;
+	}
+
+	for (auto& index : indices)
+		index = remap[index];
+
+	vertices = std::move(unique);
+}
+
+// Greedily draw the highest scoring triangle, where a triangle's score is the sum of its vertices' scores, then update the scores of vertices whose cache position changed. Only triangles using those vertices can change score, so the best candidate is found among them, falling back to the next undrawn triangle in the original order when none remain
+void optimiseVertexCache(std::vector<unsigned int>& indices, int vertexCount)
+{
+	const auto triangleCount{static_cast<int>(indices.size() / 3)};
+	if (triangleCount == 0)
+		return;
+
+	// Triangles using each vertex, stored contiguously with an offset per vertex
+	std::vector<int> triangleOffsets(vertexCount + 1, 0);
+	for (const auto index : indices)
+		++triangleOffsets[index + 1];
+	for (auto i{0}; i < vertexCount; ++i)
+		triangleOffsets[i + 1] += triangleOffsets[i];
+
+	std::vector<int> vertexTriangles(indices.size());
+	std::vector<int> remainingTriangles(vertexCount, 0);
+	for (auto triangle{0}; triangle < triangleCount; ++triangle)
+	{
+		for (auto corner{0}; corner < 3; ++corner)
+		{
+			const auto vertex{indices[triangle * 3 + corner]};
+			vertexTriangles[triangleOffsets[vertex] + remainingTriangles[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (auto vertex{0}; vertex < vertexCount; ++vertex)
+		vertexScores[vertex] = vertexScore(-1, remainingTriangles[vertex]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> drawn(triangleCount, false);
+	for (auto triangle{0}; triangle < triangleCount; ++triangle)
+		triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+
+	// Cache holds three extra entries, so vertices pushed out by a new triangle can have their scores updated
+	std::vector<unsigned int> cache{};
+	std::vector<unsigned int> nextCache{};
+	std::vector<unsigned int> optimised{};
+	optimised.reserve(indices.size());
+
+	auto bestTriangle{static_cast<int>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin())};
+	auto nextUndrawn{0};
+
+	for (auto drawnCount{0}; drawnCount < triangleCount; ++drawnCount)
+	{
+		if (bestTriangle < 0)
+		{
+			while (drawn[nextUndrawn])
+				++nextUndrawn;
+
+			bestTriangle = nextUndrawn;
+		}
+
+		drawn[bestTriangle] = true;
+
+		// Draw the triangle, moving its vertices to the front of the cache
+		nextCache.clear();
+		for (auto corner{0}; corner < 3; ++corner)
+		{
+			const auto vertex{indices[bestTriangle * 3 + corner]};
+			optimised.push_back(vertex);
+			if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+				nextCache.push_back(vertex);
+
+			// Remove the triangle from the vertex's list of remaining triangles
+			const auto first{vertexTriangles.begin() + triangleOffsets[vertex]};
+			const auto last{first + remainingTriangles[vertex]};
+			std::iter_swap(std::find(first, last, bestTriangle), last - 1);
+			--remainingTriangles[vertex];
+		}
+
+		for (const auto vertex : cache)
+		{
+			if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end())
+				nextCache.push_back(vertex);
+		}
+
+		// Vertices beyond the cache's size have been evicted
+		for (auto i{0}; i < static_cast<int>(nextCache.size()); ++i)
+		{
+			const auto vertex{nextCache[i]};
+			cachePositions[vertex] = i < lruCacheSize ? i : -1;
+			vertexScores[vertex] = vertexScore(cachePositions[vertex], remainingTriangles[vertex]);
+		}
+
+		if (nextCache.size() > lruCacheSize)
+			nextCache.resize(lruCacheSize);
+		std::swap(cache, nextCache);
+
+		// Rescore the undrawn triangles of every vertex whose score may have changed, and pick the best of them next
+		bestTriangle = -1;
+		auto bestScore{-1.0f};
+		for (const auto vertex : cache)
+		{
+			for (auto i{0}; i < remainingTriangles[vertex]; ++i)
+			{
+				const auto triangle{vertexTriangles[triangleOffsets[vertex] + i]};
+				triangleScores[triangle] = vertexScores[indices[triangle * 3]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+
+				if (triangleScores[triangle] > bestScore)
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+	}
+
+	indices = std::move(optimised);
+}
+
+void optimiseOverdraw(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, int cacheSize)
+{
+	const auto triangleCount{static_cast<int>(indices.size() / 3)};
+	if (triangleCount == 0)
+		return;
+
+	// A triangle missing the cache on all three vertices starts a new cluster, so clusters can be reordered with little effect on cache reuse
+	std::vector<int> clusterStarts{};
+	std::vector<unsigned int> fifo{};
+	for (auto triangle{0}; triangle < triangleCount; ++triangle)
+	{
+		auto misses{0};
+		for (auto corner{0}; corner < 3; ++corner)
+		{
+			const auto vertex{indices[triangle * 3 + corner]};
+			if (std::find(fifo.begin(), fifo.end(), vertex) != fifo.end())
+				continue;
+
+			++misses;
+			fifo.push_back(vertex);
+			if (fifo.size() > static_cast<std::size_t>(cacheSize))
+				fifo.erase(fifo.begin());
+		}
+
+		if (misses == 3 || triangle == 0)
+			clusterStarts.push_back(triangle);
+	}
+	clusterStarts.push_back(triangleCount);
+
+	auto meshCentre{glm::vec3{0.0f}};
+	for (const auto& vertex : vertices)
+		meshCentre += vertex.Position;
+	meshCentre /= static_cast<float>(std::max<std::size_t>(vertices.size(), 1));
+
+	// Sort key of each cluster is how directly its area-weighted average normal points away from the mesh's centre
+	struct Cluster
+	{
+		int First;
+		int Last;
+		float Sort;
+	};
+
+	std::vector<Cluster> clusters{};
+	for (std::size_t i{0}; i + 1 < clusterStarts.size(); ++i)
+	{
+		auto centroid{glm::vec3{0.0f}};
+		auto normal{glm::vec3{0.0f}};
+		auto area{0.0f};
+
+		for (auto triangle{clusterStarts[i]}; triangle < clusterStarts[i + 1]; ++triangle)
+		{
+			const auto& a{vertices[indices[triangle * 3]].Position};
+			const auto& b{vertices[indices[triangle * 3 + 1]].Position};
+			const auto& c{vertices[indices[triangle * 3 + 2]].Position};
+
+			// Length of the cross product is twice the triangle's area, so it weights both the normal and centroid
+			const auto weightedNormal{glm::cross(b - a, c - a)};
+			const auto weight{glm::length(weightedNormal)};
+
+			centroid += (a + b + c) / 3.0f * weight;
+			normal += weightedNormal;
+			area += weight;
+		}
+
+		if (area > 0.0f)
+			centroid /= area;
+
+		const auto normalLength{glm::length(normal)};
+		const auto sort{normalLength > 0.0f ? glm::dot(centroid - meshCentre, normal / normalLength) : 0.0f};
+		clusters.push_back(Cluster{clusterStarts[i], clusterStarts[i + 1], sort});
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b)
+	{
+		return a.Sort > b.Sort;
+	});
+
+	std::vector<unsigned int> sorted{};
+	sorted.reserve(indices.size());
+	for (const auto& cluster : clusters)
+		sorted.insert(sorted.end(), indices.begin() + cluster.First * 3, indices.begin() + cluster.Last * 3);
+
+	indices = std::move(sorted);
+}
+
+void optimiseVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	constexpr auto unassigned{~0u};
+
+	std::vector<unsigned int> remap(vertices.size(), unassigned);
+	std::vector<Vertex> ordered{};
+	ordered.reserve(vertices.size());
+
+	for (auto& index : indices)
+	{
+		if (remap[index] == unassigned)
+		{
+			remap[index] = static_cast<unsigned int>(ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(ordered);
+}
+
+float calculateAcmr(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize)
+{
+	const auto triangleCount{static_cast<int>(indices.size() / 3)};
+	if (triangleCount == 0)
+		return 0.0f;
+
+	// Time each vertex entered the cache, a vertex being in the cache if fewer than cacheSize misses have happened since
+	std::vector<long long> entryTimes(vertexCount, -static_cast<long long>(cacheSize) - 1);
+	long long misses{0};
+
+	for (const auto index : indices)
+	{
+		if (misses - entryTimes[index] > cacheSize)
+		{
+			entryTimes[index] = misses;
+			++misses;
+		}
+	}
+
+	return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "mesh.h"
+#include <vector>
+
+// Vertex counts and average cache miss ratios (ACMR, post-transform cache misses per triangle) before and after optimising a mesh
+struct MeshOptimisationStats
+{
+	int VerticesBefore{};
+	int VerticesAfter{};
+	float AcmrBefore{};
+	float AcmrAfter{};
+};
+
+// Optimise a triangle list for rendering: merge identical vertices, order triangles for post-transform cache reuse, optionally reorder clusters of triangles to reduce overdraw, then order vertices by first use for fetch locality. The mesh's appearance is unchanged
+MeshOptimisationStats optimiseMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, bool optimiseOverdraw = false);
+
+// Merge vertices with identical attributes, remapping indices to the remaining vertices
+void deduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Reorder triangles so recently transformed vertices are reused as often as possible, using Tom Forsyth's linear-speed vertex cache optimisation - source: https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+void optimiseVertexCache(std::vector<unsigned int>& indices, int vertexCount);
+
+// Split cache-optimised triangles into clusters where the cache restarts, and draw clusters facing outward from the mesh's centre first, so they tend to occlude later clusters (after Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+void optimiseOverdraw(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices, int cacheSize);
+
+// Reorder vertices in the order indices first reference them, dropping unreferenced vertices
+void optimiseVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// Simulate a FIFO post-transform cache of the given size, returning the average number of misses per triangle. Ranges from 3 (no reuse) down to about 0.5 for a regular grid
+float calculateAcmr(const std::vector<unsigned int>& indices, int vertexCount, int cacheSize);
@@ -0,0 +1,300 @@
+#include "meshsimplifier.h"
+#include "meshoptimiser.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+
+namespace
+{
+	// A level must have at most this fraction of the previous level's indices to be worth keeping
+	constexpr auto minimumReduction{0.85f};
+
+	// Cosine of the largest angle a triangle's normal may turn through in one collapse. Limiting each turn stops triangles being flipped over by several collapses in a row
+	constexpr auto maxNormalChange{0.5f};
+
+	// Largest error allowed for the first simplified level, as a fraction of the mesh's size
+	constexpr auto firstLevelError{0.02f};
+
+	// Levels aren't generated below this many triangles, as the per-draw cost outweighs any vertex savings
+	constexpr auto minimumTriangles{8};
+
+	// Symmetric 4x4 matrix measuring the sum of squared distances to a set of planes, stored as its upper triangle
+	struct Quadric
+	{
+		double A00{}, A01{}, A02{}, A03{};
+		double A11{}, A12{}, A13{};
+		double A22{}, A23{};
+		double A33{};
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			A00 += other.A00; A01 += other.A01; A02 += other.A02; A03 += other.A03;
+			A11 += other.A11; A12 += other.A12; A13 += other.A13;
+			A22 += other.A22; A23 += other.A23;
+			A33 += other.A33;
+
+			return *this;
+		}
+
+		// Quadric of the plane through a triangle, weighted by the triangle's area so large faces resist change more than small ones
+		static Quadric fromTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+		{
+			const auto cross{glm::cross(b - a, c - a)};
+			const auto length{glm::length(cross)};
+			if (length == 0.0f)
+				return Quadric{};
+
+			const auto normal{cross / length};
+			const auto weight{static_cast<double>(length) * 0.5};
+			const double x{normal.x}, y{normal.y}, z{normal.z}, d{-glm::dot(normal, a)};
+
+			return Quadric{x * x * weight, x * y * weight, x * z * weight, x * d * weight, y * y * weight, y * z * weight, y * d * weight, z * z * weight, z * d * weight, d * d * weight};
+		}
+
+		// Mean squared distance from the point to the planes in the quadric, weighted by area. Plane normals are unit length, so the trace of the upper 3x3 is the total weight
+		double error(const glm::vec3& point) const
+		{
+			const auto weight{A00 + A11 + A22};
+			if (weight <= 0.0)
+				return 0.0;
+
+			const double x{point.x}, y{point.y}, z{point.z};
+
+			const auto sum{A00 * x * x + 2.0 * A01 * x * y + 2.0 * A02 * x * z + 2.0 * A03 * x
+				+ A11 * y * y + 2.0 * A12 * y * z + 2.0 * A13 * y
+				+ A22 * z * z + 2.0 * A23 * z
+				+ A33};
+
+			return sum / weight;
+		}
+	};
+
+	// A possible collapse of one vertex onto another
+	struct Collapse
+	{
+		unsigned int From;
+		unsigned int To;
+		double Error;
+	};
+
+	std::uint64_t edgeKey(unsigned int a, unsigned int b)
+	{
+		return static_cast<std::uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+	}
+
+	// Whether moving a vertex onto another would turn any of the triangles that remain afterwards too far
+	bool flipsTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, const std::vector<int>& triangles, unsigned int from, unsigned int to)
+	{
+		for (const auto triangle : triangles)
+		{
+			const auto* corners{&indices[triangle * 3]};
+
+			// Triangles using both vertices are removed by the collapse
+			if (corners[0] == to || corners[1] == to || corners[2] == to)
+				continue;
+
+			glm::vec3 before[3]{};
+			glm::vec3 after[3]{};
+			for (auto i{0}; i < 3; ++i)
+			{
+				before[i] = vertices[corners[i]].Position;
+				after[i] = vertices[corners[i] == from ? to : corners[i]].Position;
+			}
+
+			// Compare unnormalised normals, scaling the threshold by their lengths rather than dividing. Degenerate triangles have zero normals, so are rejected too
+			const auto normalBefore{glm::cross(before[1] - before[0], before[2] - before[0])};
+			const auto normalAfter{glm::cross(after[1] - after[0], after[2] - after[0])};
+			if (glm::dot(normalBefore, normalAfter) <= maxNormalChange * glm::length(normalBefore) * glm::length(normalAfter))
+				return true;
+
+			// Turns are limited per collapse, so also check against the original vertex normals, which never change, to stop turns accumulating over several collapses
+			for (auto i{0}; i < 3; ++i)
+			{
+				const auto corner{corners[i] == from ? to : corners[i]};
+				if (glm::dot(normalAfter, vertices[corner].Normal) <= 0.0f)
+					return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+// Collapse edges in passes. Each pass finds the cheapest collapse for every edge and applies as many as possible, cheapest first, without letting two collapses in the same pass affect the same triangles
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int targetIndexCount, float maxError)
+{
+	const auto vertexCount{static_cast<unsigned int>(vertices.size())};
+	auto result{indices};
+	if (vertices.empty())
+		return result;
+
+	// Errors are squared distances, so compare against the squared limit scaled to the size of the mesh
+	auto min{vertices.front().Position};
+	auto max{vertices.front().Position};
+	for (const auto& vertex : vertices)
+	{
+		min = glm::min(min, vertex.Position);
+		max = glm::max(max, vertex.Position);
+	}
+	const auto scaledError{static_cast<double>(maxError) * glm::length(max - min)};
+	const auto errorLimit{scaledError * scaledError};
+
+	std::vector<Quadric> quadrics(vertexCount);
+	for (std::size_t i{0}; i + 2 < result.size(); i += 3)
+	{
+		const auto quadric{Quadric::fromTriangle(vertices[result[i]].Position, vertices[result[i + 1]].Position, vertices[result[i + 2]].Position)};
+		for (auto corner{0}; corner < 3; ++corner)
+			quadrics[result[i + corner]] += quadric;
+	}
+
+	// Edges used by only one triangle are open, so their vertices are locked
+	std::unordered_map<std::uint64_t, int> edgeUses{};
+	for (std::size_t i{0}; i + 2 < result.size(); i += 3)
+	{
+		for (auto corner{0}; corner < 3; ++corner)
+			++edgeUses[edgeKey(result[i + corner], result[i + (corner + 1) % 3])];
+	}
+
+	std::vector<bool> locked(vertexCount, false);
+	for (const auto& edge : edgeUses)
+	{
+		if (edge.second == 1)
+		{
+			locked[static_cast<unsigned int>(edge.first >> 32)] = true;
+			locked[static_cast<unsigned int>(edge.first & 0xffffffff)] = true;
+		}
+	}
+
+	std::vector<Collapse> collapses{};
+	std::vector<std::vector<int>> vertexTriangles(vertexCount);
+	std::vector<bool> touched(vertexCount);
+	std::vector<unsigned int> remap(vertexCount);
+
+	while (result.size() > static_cast<std::size_t>(targetIndexCount))
+	{
+		const auto triangleCount{static_cast<int>(result.size() / 3)};
+
+		for (auto& triangles : vertexTriangles)
+			triangles.clear();
+		for (auto triangle{0}; triangle < triangleCount; ++triangle)
+		{
+			for (auto corner{0}; corner < 3; ++corner)
+				vertexTriangles[result[triangle * 3 + corner]].push_back(triangle);
+		}
+
+		// Find the cheapest allowed direction to collapse each edge. Edges shared by two triangles appear once in each direction, so only visit them from their lower index; open edges only appear once, but their vertices are locked anyway
+		collapses.clear();
+		for (std::size_t i{0}; i < result.size(); ++i)
+		{
+			const auto a{result[i]};
+			const auto b{result[i - i % 3 + (i + 1) % 3]};
+			if (a > b)
+				continue;
+
+			auto best{Collapse{a, b, -1.0}};
+			auto combined{quadrics[a]};
+			combined += quadrics[b];
+
+			if (!locked[a])
+				best = Collapse{a, b, combined.error(vertices[b].Position)};
+
+			if (!locked[b])
+			{
+				const auto error{combined.error(vertices[a].Position)};
+				if (best.Error < 0.0 || error < best.Error)
+					best = Collapse{b, a, error};
+			}
+
+			if (best.Error >= 0.0 && best.Error <= errorLimit)
+				collapses.push_back(best);
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+		{
+			return a.Error < b.Error;
+		});
+
+		std::fill(touched.begin(), touched.end(), false);
+		for (auto i{0u}; i < vertexCount; ++i)
+			remap[i] = i;
+
+		auto remainingTriangles{triangleCount};
+		auto collapsed{0};
+		for (const auto& collapse : collapses)
+		{
+			if (remainingTriangles * 3 <= targetIndexCount)
+				break;
+
+			if (touched[collapse.From] || touched[collapse.To])
+				continue;
+
+			const auto& triangles{vertexTriangles[collapse.From]};
+			if (flipsTriangles(vertices, result, triangles, collapse.From, collapse.To))
+				continue;
+
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To] += quadrics[collapse.From];
+			++collapsed;
+
+			// Every vertex sharing a triangle with the moved vertex is left alone for the rest of the pass, as its triangles have changed shape
+			for (const auto triangle : triangles)
+			{
+				const auto* corners{&result[triangle * 3]};
+				if (corners[0] == collapse.To || corners[1] == collapse.To || corners[2] == collapse.To)
+					--remainingTriangles;
+
+				for (auto corner{0}; corner < 3; ++corner)
+					touched[corners[corner]] = true;
+			}
+		}
+
+		if (collapsed == 0)
+			break;
+
+		// Apply the collapses, dropping triangles that have lost a vertex
+		auto kept{0};
+		for (auto triangle{0}; triangle < triangleCount; ++triangle)
+		{
+			const auto a{remap[result[triangle * 3]]};
+			const auto b{remap[result[triangle * 3 + 1]]};
+			const auto c{remap[result[triangle * 3 + 2]]};
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[kept++] = a;
+			result[kept++] = b;
+			result[kept++] = c;
+		}
+		result.resize(kept);
+	}
+
+	return result;
+}
+
+std::vector<std::vector<unsigned int>> generateLods(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int maxLevels)
+{
+	std::vector<std::vector<unsigned int>> levels{indices};
+	auto maxError{firstLevelError};
+
+	while (levels.size() < static_cast<std::size_t>(maxLevels))
+	{
+		const auto& previous{levels.back()};
+		const auto target{static_cast<int>(previous.size() / 6) * 3};
+		if (target < minimumTriangles * 3)
+			break;
+
+		auto level{simplifyMesh(vertices, previous, target, maxError)};
+		if (level.size() > previous.size() * minimumReduction)
+			break;
+
+		maxError *= 2.0f;
+
+		// Simplification leaves triangles in their original order with gaps, so restore cache locality
+		optimiseVertexCache(level, static_cast<int>(vertices.size()));
+		levels.push_back(std::move(level));
+	}
+
+	return levels;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "mesh.h"
+#include <vector>
+
+// Simplify a triangle list to at most targetIndexCount indices by collapsing edges in order of least quadric error (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics"). Vertices are only ever collapsed onto other existing vertices, so the result indexes into the same vertex array. Vertices on open edges, including texture seams, are never moved, keeping the outline and seams of the mesh intact. Collapses that would move the surface further than maxError (as a fraction of the mesh's size) are not made, so the target may not be reached
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int targetIndexCount, float maxError);
+
+// Generate a chain of index lists for levels of detail, starting with the given indices and halving the triangle count each level, up to maxLevels in total. Each level allows twice the error of the last. The chain stops early once simplification stops making meaningful progress
+std::vector<std::vector<unsigned int>> generateLods(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, int maxLevels);
@@ -1,59 +1,283 @@
 #include "model.h"
+#include "jobsystem.h"
+#include "meshoptimiser.h"
+#include "meshsimplifier.h"
 #include <assimp/postprocess.h>
-#include "stb_image.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <sstream>
+#include <system_error>
+#include <utility>
 
-Model::Model(const std::string& path)
+namespace
 {
-	loadSceneFromFile(path);
+	// Number of levels of detail generated for each mesh, including full detail
+	constexpr auto maxLods{4};
+
+	// Processing applied by Assimp when importing, whether loading or baking
+	constexpr auto importFlags{aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace};
+
+	// Whether the baked copy of a model file exists and is no older than the file. A baked copy without its source is used as is, so releases can ship baked copies alone
+	bool isBakedFileCurrent(const std::string& path, const std::string& bakedPath)
+	{
+		std::error_code error{};
+		const auto bakedTime{std::filesystem::last_write_time(bakedPath, error)};
+		if (error)
+			return false;
+
+		const auto sourceTime{std::filesystem::last_write_time(path, error)};
+		if (error)
+			return true;
+
+		if (sourceTime > bakedTime)
+		{
+			std::cout << "Baked model \"" + bakedPath + "\" is older than its source, so importing the source instead\n";
+
+			return false;
+		}
+
+		return true;
+	}
+}
+
+Model::Model(const std::string& path, GeometryManager& geometry, MeshRetention retention) : Model{readSource(path, geometry, retention), geometry}
+{
+}
+
+// Baked meshes are uploaded straight from the mapped file, as importing, optimising, simplifying, and packing were all done when baking
+Model::Model(Source source, GeometryManager& geometry) : Path{std::move(source.Path)}, Retention{source.Retention}
+{
+	// Cache the directory of the loaded file, which texture paths are relative to
+	Directory = Path.substr(0, Path.find_last_of('/'));
+
+	if (source.Baked)
+	{
+		for (const auto& mesh : source.Baked->getMeshes())
+			Meshes.push_back(Mesh{mesh.Geometry, loadTextures(mesh.Textures, source), mesh.Bounds, geometry});
+	}
+
+	for (const auto& imported : source.Imported)
+		Meshes.push_back(Mesh{imported.Vertices, imported.Lods, loadTextures(imported.Textures, source), imported.Bounds, geometry, Retention});
+
+	calculateModelBounds();
 }
 
-// Draw the model by sequentially drawing all its constituent meshes
-void Model::draw(const Shader& shader, const glm::mat4& trans) const
+// Draw the model by queueing draws of all its constituent meshes
+void Model::draw(RenderQueue& queue, RenderPass pass, const Shader& shader, int lod, int baseInstance, int instanceCount) const
 {
 	for (const auto& mesh : Meshes)
-		mesh.draw(shader, trans);
+		queue.push(pass, shader, mesh, std::min(lod, mesh.getLodCount() - 1), baseInstance, instanceCount);
+}
+
+// Meshes are simplified independently, so may stop at different levels of detail
+int Model::getLodCount() const
+{
+	auto lodCount{1};
+	for (const auto& mesh : Meshes)
+		lodCount = std::max(lodCount, mesh.getLodCount());
+
+	return lodCount;
+}
+
+// Textures are decoded in one pass over the whole model, so textures shared by several meshes are only decoded once
+Model::Source Model::readSource(const std::string& path, const GeometryManager& geometry, MeshRetention retention, JobSystem* jobs)
+{
+	Source source{};
+	source.Path = path;
+	source.Retention = retention;
+
+	if (!readBakedFile(source, geometry))
+		importScene(source);
+
+	std::vector<std::string> texturePaths{};
+	const auto addTextures{[&texturePaths](const std::vector<Texture>& textures)
+	{
+		for (const auto& texture : textures)
+		{
+			if (std::find(texturePaths.begin(), texturePaths.end(), texture.Path) == texturePaths.end())
+				texturePaths.push_back(texture.Path);
+		}
+	}};
+
+	if (source.Baked)
+	{
+		for (const auto& mesh : source.Baked->getMeshes())
+			addTextures(mesh.Textures);
+	}
+
+	for (const auto& imported : source.Imported)
+		addTextures(imported.Textures);
+
+	const auto directory{path.substr(0, path.find_last_of('/'))};
+	std::vector<DecodedImage> images(texturePaths.size());
+	const auto decode{[&texturePaths, &images, &directory](int begin, int end)
+	{
+		for (auto i{begin}; i < end; ++i)
+			images[i] = decodeImage(directory + "/" + texturePaths[i]);
+	}};
+
+	if (jobs)
+		jobs->parallelFor(0, static_cast<int>(texturePaths.size()), 1, decode);
+	else
+		decode(0, static_cast<int>(texturePaths.size()));
+
+	for (std::size_t i{0}; i < texturePaths.size(); ++i)
+		source.Images.emplace(texturePaths[i], std::move(images[i]));
+
+	return source;
+}
+
+// Baked copies are never read, as they hold no more than MeshRetention::NONE keeps
+Model::Source Model::readMeshes(const std::string& path, MeshRetention retention)
+{
+	Source source{};
+	source.Path = path;
+	source.Retention = retention;
+
+	importScene(source);
+
+	return source;
+}
+
+// Importing a file always produces its meshes in the same order, so they are matched by position. A file changed since the model was loaded may not match, so nothing is kept unless every mesh does
+bool Model::retain(const Source& source)
+{
+	if (source.Retention <= Retention)
+		return true;
+
+	if (source.Imported.size() != Meshes.size())
+		return false;
+
+	for (std::size_t i{0}; i < Meshes.size(); ++i)
+	{
+		if (static_cast<int>(source.Imported[i].Lods.front().size()) != Meshes[i].getIndexCount())
+			return false;
+	}
+
+	for (std::size_t i{0}; i < Meshes.size(); ++i)
+		Meshes[i].retain(source.Imported[i].Vertices, source.Imported[i].Lods, source.Retention);
+
+	Retention = source.Retention;
+
+	return true;
+}
+
+// Map the baked copy of the model, returning false if there is no usable copy
+bool Model::readBakedFile(Source& source, const GeometryManager& geometry)
+{
+	// Baked files hold only what drawing needs
+	if (source.Retention != MeshRetention::NONE)
+		return false;
+
+	const auto bakedPath{getBakedPath(source.Path)};
+	if (!isBakedFileCurrent(source.Path, bakedPath))
+		return false;
+
+	auto baked{std::make_unique<BakedModel>(bakedPath)};
+	if (!baked->isValid())
+		return false;
+
+	// Files baked for a different vertex format would put their meshes in pools of their own, so are imported again instead
+	for (const auto& mesh : baked->getMeshes())
+	{
+		if (mesh.Geometry.Layout != geometry.getLayout(mesh.Geometry.Layout == VertexLayout::PACKED_TANGENTS))
+		{
+			std::cout << "Baked model \"" + bakedPath + "\" has a different vertex format, so importing the source instead\n";
+
+			return false;
+		}
+	}
+
+	std::cout << "Read baked model \"" + bakedPath + "\": " + std::to_string(baked->getMeshes().size()) + " meshes\n";
+
+	source.Baked = std::move(baked);
+
+	return true;
 }
 
 // Load the scene (collection of meshes) from the given file
-void Model::loadSceneFromFile(const std::string& path)
+void Model::importScene(Source& source)
 {
 	Assimp::Importer importer{};
 
-	const auto scene{importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace)};
+	const auto scene{importer.ReadFile(source.Path, importFlags)};
 
 	// Check for errors in the loaded scene
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
 	{
-		std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << "\n";
+		std::cout << std::string{"ERROR::ASSIMP:: "} + importer.GetErrorString() + "\n";
 
 		return;
 	}
 
-	// Cache the directory of the loaded file
-	Directory = path.substr(0, path.find_last_of('/'));
+	std::vector<const aiMesh*> meshes{};
+	getMeshesInNode(scene->mRootNode, scene, meshes);
 
-	getMeshesInNode(scene->mRootNode, scene);
+	for (const auto mesh : meshes)
+		source.Imported.push_back(importMesh(mesh, scene));
 }
 
-// Get and store all meshes from each scene node
-void Model::getMeshesInNode(const aiNode* node, const aiScene* scene)
+// Meshes are packed exactly as add would pack them, so loading the baked copy uploads the same data that importing would have
+bool Model::bake(const std::string& path, GeometryManager& geometry)
 {
-	// Process each mesh in the current node
-	for (auto i{0}; i < node->mNumMeshes; ++i)
+	Assimp::Importer importer{};
+
+	const auto scene{importer.ReadFile(path, importFlags)};
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << "\n";
+
+		return false;
+	}
+
+	std::vector<const aiMesh*> meshes{};
+	getMeshesInNode(scene->mRootNode, scene, meshes);
+
+	BakedModelWriter writer{};
+	for (const auto mesh : meshes)
 	{
-		// Node contains only indices of objects in the scene, so use them retrieve the actual meshes
-		const auto mesh{scene->mMeshes[node->mMeshes[i]]};
-		Meshes.push_back(storeMeshData(mesh, scene));
+		const auto imported{importMesh(mesh, scene)};
+		writer.addMesh(geometry.pack(imported.Vertices, imported.Lods, Mesh::needsTangents(imported.Textures)), imported.Bounds, imported.Textures);
 	}
 
+	const auto bakedPath{getBakedPath(path)};
+	if (!writer.write(bakedPath))
+		return false;
+
+	std::cout << "Baked \"" << path << "\" to \"" << bakedPath << "\": " << meshes.size() << " meshes\n";
+
+	return true;
+}
+
+std::string Model::getBakedPath(const std::string& path)
+{
+	// Only a dot after the last directory separator starts an extension
+	const auto extension{path.find_last_of('.')};
+	const auto directory{path.find_last_of('/')};
+	if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+		return path + ".bmesh";
+
+	return path.substr(0, extension) + ".bmesh";
+}
+
+// Get all meshes from each scene node
+void Model::getMeshesInNode(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes)
+{
+	// Node contains only indices of objects in the scene, so use them retrieve the actual meshes
+	for (auto i{0}; i < node->mNumMeshes; ++i)
+		meshes.push_back(scene->mMeshes[node->mMeshes[i]]);
+
 	// Repeat above for all sub-nodes (if any)
 	for (auto i{0}; i < node->mNumChildren; ++i)
-		getMeshesInNode(node->mChildren[i], scene);
+		getMeshesInNode(node->mChildren[i], scene, meshes);
 }
 
-// Convert retrieved mesh into Mesh object
-Mesh Model::storeMeshData(const aiMesh* mesh, const aiScene* scene)
+// Convert retrieved mesh into vertices and indices, then process them for drawing
+Model::ImportedMesh Model::importMesh(const aiMesh* mesh, const aiScene* scene)
 {
 	std::vector<Vertex> vertices{};
 	std::vector<unsigned int> indices{};
@@ -125,30 +349,93 @@ Mesh Model::storeMeshData(const aiMesh* mesh, const aiScene* scene)
 	const auto material{scene->mMaterials[mesh->mMaterialIndex]};
 
 	// A sampler naming convention in shaders is assumed
-	// Diffuse textures should be named "texture_<type>N" where N is between 1 and MAX_SAMPLER_NUMBER and type is one of "diffuse", "specular", and "normal".
+	// Diffuse textures should be named "texture_<type>N" where N is between 1 and 4 and type is one of "diffuse", "specular", and "normal".
 
 	// Diffuse maps
-	const auto diffuseMaps{storeMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse")};
+	const auto diffuseMaps{getMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse")};
 	textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
 	// Specular maps
-	const auto specularMaps{storeMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular")};
+	const auto specularMaps{getMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular")};
 	textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
 	// Normal maps
-	const auto normalMaps{storeMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal")};
+	const auto normalMaps{getMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal")};
 	textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
 
 	// Height maps
-	const auto heightMaps{storeMaterialTextures(material, aiTextureType_AMBIENT, "texture_height")};
+	const auto heightMaps{getMaterialTextures(material, aiTextureType_AMBIENT, "texture_height")};
 	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-	// Return the completed mesh object containing the retrieved vertices, indices, and textures
-	return Mesh{vertices, indices, textures};
+	// Files store faces in whatever order they were authored, often with every face having its own copies of shared vertices, so reorder for the GPU's caches
+	const auto stats{optimiseMesh(vertices, indices)};
+
+	// Generate simplified versions of the mesh to draw when it is far away
+	auto lods{generateLods(vertices, indices, maxLods)};
+
+	// Meshes may be imported on several threads at once, so the report is written in one go to keep it from being interleaved with others
+	std::ostringstream report{};
+	report << "Optimised mesh \"" << mesh->mName.C_Str() << "\": vertices " << stats.VerticesBefore << " -> " << stats.VerticesAfter << ", ACMR " << stats.AcmrBefore << " -> " << stats.AcmrAfter << ", LOD triangles";
+	for (const auto& lod : lods)
+		report << " " << lod.size() / 3;
+	report << "\n";
+	std::cout << report.str();
+
+	// Return the processed mesh containing the retrieved vertices, indices, and textures
+	const auto bounds{calculateBounds(vertices)};
+	return ImportedMesh{std::move(vertices), std::move(lods), std::move(textures), bounds};
 }
 
-// Get and store the textures contained within the given material
-std::vector<Texture> Model::storeMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName)
+// Calculate the bounding box of the vertices, and a sphere centred on the box that encloses every vertex
+BoundingVolume Model::calculateBounds(const std::vector<Vertex>& vertices)
+{
+	BoundingVolume bounds{};
+	if (vertices.empty())
+		return bounds;
+
+	bounds.Min = vertices.front().Position;
+	bounds.Max = vertices.front().Position;
+	for (const auto& vertex : vertices)
+	{
+		bounds.Min = glm::min(bounds.Min, vertex.Position);
+		bounds.Max = glm::max(bounds.Max, vertex.Position);
+	}
+
+	bounds.Centre = (bounds.Min + bounds.Max) * 0.5f;
+
+	auto radiusSquared{0.0f};
+	for (const auto& vertex : vertices)
+	{
+		const auto offset{vertex.Position - bounds.Centre};
+		radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+	}
+	bounds.Radius = std::sqrt(radiusSquared);
+
+	return bounds;
+}
+
+// Combine mesh bounds into bounds for the whole model, with the sphere centred on the combined box and enclosing every mesh's sphere
+void Model::calculateModelBounds()
+{
+	if (Meshes.empty())
+		return;
+
+	Bounds.Min = Meshes.front().getBounds().Min;
+	Bounds.Max = Meshes.front().getBounds().Max;
+	for (const auto& mesh : Meshes)
+	{
+		Bounds.Min = glm::min(Bounds.Min, mesh.getBounds().Min);
+		Bounds.Max = glm::max(Bounds.Max, mesh.getBounds().Max);
+	}
+
+	Bounds.Centre = (Bounds.Min + Bounds.Max) * 0.5f;
+	Bounds.Radius = 0.0f;
+	for (const auto& mesh : Meshes)
+		Bounds.Radius = std::max(Bounds.Radius, glm::distance(Bounds.Centre, mesh.getBounds().Centre) + mesh.getBounds().Radius);
+}
+
+// Get the textures contained within the given material, without loading them
+std::vector<Texture> Model::getMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName)
 {
 	std::vector<Texture> textures{};
 
@@ -157,51 +444,57 @@ std::vector<Texture> Model::storeMaterialTextures(const aiMaterial* mat, aiTextu
 		aiString str{};
 		mat->GetTexture(type, i, &str);
 
-		// Skip creating objects for textures that have already been loaded and cached
-		bool skip{false};
-		for (auto j{0}; j < TexturesLoaded.size(); ++j)
-		{
-			// Textures with identical file paths are assumed to be the same
-			if (std::strcmp(TexturesLoaded[j].Path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(TexturesLoaded[j]);
+		Texture texture{};
+		texture.Type = typeName;
+		texture.Path = str.C_Str();
+		textures.push_back(texture);
+	}
+
+	return textures;
+}
 
-				skip = true;
+std::vector<Texture> Model::loadTextures(const std::vector<Texture>& textures, const Source& source)
+{
+	std::vector<Texture> loaded{};
 
-				break;
-			}
-		}
+	for (const auto& texture : textures)
+	{
+		// Skip creating objects for textures that have already been loaded and cached. Textures with identical file paths are assumed to be the same
+		const auto cached{std::find_if(TexturesLoaded.begin(), TexturesLoaded.end(), [&texture](const Texture& cachedTexture)
+		{
+			return cachedTexture.Path == texture.Path;
+		})};
 
-		if (!skip)
+		if (cached != TexturesLoaded.end())
 		{
-			// Create objects for new textures
-			Texture texture{};
-			texture.Id = loadTextureFromFile(str.C_Str(), Directory);
-			texture.Type = typeName;
-			texture.Path = str.C_Str();
-			textures.push_back(texture);
-
-			// Store it as texture loaded for entire model, to prevent unnecessarily loading duplicate textures.
-			TexturesLoaded.push_back(texture);
+			loaded.push_back(*cached);
+
+			continue;
 		}
+
+		// Create objects for new textures from the images decoded while reading the model
+		const auto image{source.Images.find(texture.Path)};
+		TextureObjects.push_back(image != source.Images.end() ? createTexture(image->second, texture.Path) : TextureHandle{});
+		loaded.push_back(Texture{TextureObjects.back().get(), texture.Type, texture.Path});
+
+		// Store it as texture loaded for entire model, to prevent unnecessarily loading duplicate textures.
+		TexturesLoaded.push_back(loaded.back());
 	}
 
-	// Return the completed texture object(s)
-	return textures;
+	return loaded;
 }
 
-// Load a texture from a file and configure it for use in OpenGL
-unsigned int Model::loadTextureFromFile(const std::string& path, const std::string& directory, bool gamma)
+// Create a texture from a decoded image and configure it for use in OpenGL
+TextureHandle Model::createTexture(const DecodedImage& image, const std::string& path)
 {
-	const auto filename{directory + "/" + path};
-
 	unsigned int textureId{};
+	long long textureBytes{};
 
-	int width{};
-	int height{};
-	int numComponents{};
+	const auto width{image.Width};
+	const auto height{image.Height};
+	const auto numComponents{image.Components};
 
-	const auto texData{stbi_load(filename.c_str(), &width, &height, &numComponents, 0)};
+	const auto texData{image.Data.get()};
 	if (texData)
 	{
 		GLenum format{};
@@ -234,12 +527,13 @@ unsigned int Model::loadTextureFromFile(const std::string& path, const std::stri
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 		glBindTexture(GL_TEXTURE_2D, 0);
+
+		// The driver chooses how unsized formats are stored, so count the image as loaded, plus a third for its mipmaps
+		textureBytes = static_cast<long long>(width) * height * numComponents * 4 / 3;
 	}
 	else
 		std::cout << "Texture failed to load at path: " << path << "\n";
 
-	stbi_image_free(texData);
-
-	// Return the id of the generated OpenGL texture
-	return textureId;
+	// Return the generated OpenGL texture, or an empty handle if it failed to load
+	return TextureHandle{textureId, textureBytes};
 }
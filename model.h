@@ -1,32 +1,127 @@
 #pragma once
 
+#include "bakedmodel.h"
+#include "gpuresource.h"
+#include "image.h"
 #include "mesh.h"
+#include "renderqueue.h"
 #include "shader.h"
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+class JobSystem;
+
 // Class representing a 3D model composed of one or meshes. Handles loading model data from file using Assimp and rendering constituent meshes. Declaration and implementation code is based on example provided by LearnOpenGL.com - source: https://learnopengl.com/Model-Loading/Model
 class Model
 {
 public:
-	Model(const std::string& path);
+	// Mesh imported from file and processed ready for upload, with textures not yet loaded
+	struct ImportedMesh
+	{
+		std::vector<Vertex> Vertices{};
+		std::vector<std::vector<unsigned int>> Lods{};
+		std::vector<Texture> Textures{};
+		BoundingVolume Bounds{};
+	};
+
+	// Everything loading a model reads from disk and works out before any OpenGL objects are created: the mapped baked copy of the model or the meshes imported from its file, and its decoded textures
+	struct Source
+	{
+		std::string Path{};
+		MeshRetention Retention{};
+		std::unique_ptr<BakedModel> Baked{};
+		std::vector<ImportedMesh> Imported{};
+
+		// Decoded textures, by path relative to the model's directory
+		std::unordered_map<std::string, DecodedImage> Images{};
+	};
+
+	// Load the model, uploading its meshes to the given geometry buffers and keeping only the CPU-side mesh data retention asks for. A baked copy of the model (see bake) is loaded in place of the file at path when there is one at least as new as the file, unless retention needs more than the baked copy holds
+	Model(const std::string& path, GeometryManager& geometry, MeshRetention retention = MeshRetention::NONE);
+
+	// Create the model's OpenGL objects from a source read by readSource, uploading its meshes to the given geometry buffers. Must run on the thread owning the OpenGL context
+	Model(Source source, GeometryManager& geometry);
+
+	// Do the part of loading the model at path that needs no OpenGL context: reading and processing its meshes and decoding its textures. Safe to run on any thread, with textures decoded in parallel if given a job system
+	static Source readSource(const std::string& path, const GeometryManager& geometry, MeshRetention retention, JobSystem* jobs = nullptr);
+
+	// Import the meshes of the model file at path with nothing else read, for retain. Safe to run on any thread
+	static Source readMeshes(const std::string& path, MeshRetention retention);
+
+	// Keep the CPU-side mesh data the retention of a source read by readMeshes asks for, for a model loaded with less. Nothing is uploaded, as the model's meshes are already on the GPU. Returns false, leaving the model as it was, if the source's meshes don't match the model's
+	bool retain(const Source& source);
+
+	// Models are shared through AssetManager rather than copied, as copies would duplicate every mesh's data while aliasing the same GPU buffers and textures
+	Model(const Model&) = delete;
+	Model& operator=(const Model&) = delete;
+
+	// Queue instanced draws of every mesh in the model at the given level of detail, see RenderQueue::push
+	void draw(RenderQueue& queue, RenderPass pass, const Shader& shader, int lod, int baseInstance, int instanceCount) const;
+
+	// Get the number of levels of detail of the model's most detailed mesh. Meshes with fewer levels use their coarsest level in place of those they lack
+	int getLodCount() const;
 
-	void draw(const Shader& shader, const glm::mat4& trans) const;
+	// Get the bounds enclosing every mesh in the model
+	const BoundingVolume& getBounds() const
+	{
+		return Bounds;
+	}
+
+	// Get the path the model was loaded from
+	const std::string& getPath() const
+	{
+		return Path;
+	}
+
+	// Get how much CPU-side data the model's meshes kept after upload
+	MeshRetention getRetention() const
+	{
+		return Retention;
+	}
+
+	const std::vector<Mesh>& getMeshes() const
+	{
+		return Meshes;
+	}
+
+	// Import the model file at path and process its meshes as loading would, writing the result to the baked copy loaded in its place. Needs no OpenGL context, as nothing is uploaded. Returns whether the baked copy was written
+	static bool bake(const std::string& path, GeometryManager& geometry);
+
+	// Get the path of the baked copy of the model file at path: the same path with the extension ".bmesh"
+	static std::string getBakedPath(const std::string& path);
 
 private:
 	std::vector<Texture> TexturesLoaded{};
+
+	// Texture objects used by the model's meshes, owned here as meshes may share them
+	std::vector<TextureHandle> TextureObjects{};
 	std::vector<Mesh> Meshes{};
 	std::string Directory{};
+	std::string Path{};
+	BoundingVolume Bounds{};
+	MeshRetention Retention{};
+
+	static bool readBakedFile(Source& source, const GeometryManager& geometry);
+
+	static void importScene(Source& source);
+
+	static void getMeshesInNode(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*>& meshes);
+
+	static ImportedMesh importMesh(const aiMesh* mesh, const aiScene* scene);
 
-	void loadSceneFromFile(const std::string& path);
+	static BoundingVolume calculateBounds(const std::vector<Vertex>& vertices);
 
-	void getMeshesInNode(const aiNode* node, const aiScene* scene);
+	// Combine the bounds of every mesh into bounds for the whole model
+	void calculateModelBounds();
 
-	Mesh storeMeshData(const aiMesh* mesh, const aiScene* scene);
+	static std::vector<Texture> getMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName);
 
-	std::vector<Texture> storeMaterialTextures(const aiMaterial* mat, aiTextureType type, const std::string& typeName);
+	// Give each texture the id of its texture object, creating objects from the source's decoded images for textures the model hasn't loaded yet
+	std::vector<Texture> loadTextures(const std::vector<Texture>& textures, const Source& source);
 
-	static unsigned int loadTextureFromFile(const std::string& path, const std::string& directory, bool gamma = false);
+	static TextureHandle createTexture(const DecodedImage& image, const std::string& path);
 };
@@ -0,0 +1,442 @@
+#include "occlusionculler.h"
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OCCLUSION_SSE2
+#endif
+
+namespace
+{
+	// Pixels processed per iteration of the rasterizer's inner loop. The buffer's width is a multiple of every lane count, so blocks never straddle rows
+#if defined(__AVX2__)
+	constexpr auto laneCount{8};
+#elif defined(OCCLUSION_SSE2)
+	constexpr auto laneCount{4};
+#else
+	constexpr auto laneCount{1};
+#endif
+
+	static_assert(OcclusionCuller::Width % 8 == 0 && OcclusionCuller::Width % OcclusionCuller::TileSize == 0 && OcclusionCuller::Height % OcclusionCuller::TileSize == 0, "Depth buffer must be made of whole tiles and SIMD blocks");
+
+	constexpr auto tileColumns{OcclusionCuller::Width / OcclusionCuller::TileSize};
+	constexpr auto tileRows{OcclusionCuller::Height / OcclusionCuller::TileSize};
+
+	// Faces of a box as indices of its corners, where bit 0 of an index selects the maximum x, bit 1 the maximum y, and bit 2 the maximum z. Wound anticlockwise seen from outside the box, so faces pointing away from the camera can be skipped
+	constexpr int boxFaces[][4]
+	{
+		{0, 4, 6, 2}, // -X
+		{1, 3, 7, 5}, // +X
+		{0, 1, 5, 4}, // -Y
+		{2, 6, 7, 3}, // +Y
+		{0, 2, 3, 1}, // -Z
+		{4, 5, 7, 6}  // +Z
+	};
+
+	// Most points a box clipped by the near plane can have: its eight corners and a point on each of its twelve edges, although never all at once
+	constexpr auto maxOutlinePoints{20};
+
+	glm::vec3 getCorner(const glm::vec3& min, const glm::vec3& max, int index)
+	{
+		return glm::vec3{index & 1 ? max.x : min.x, index & 2 ? max.y : min.y, index & 4 ? max.z : min.z};
+	}
+
+	// Signed distance from the near plane in clip space, positive in front of it
+	float getNearDistance(const glm::vec4& clip)
+	{
+		return clip.z + clip.w;
+	}
+}
+
+OcclusionCuller::OcclusionCuller() : viewProjection_{1.0f}, cameraPosition_{0.0f}, frustum_{}, candidates_{}, occluderCount_{0}, depth_(Width * Height, 1.0f), tileDepth_(tileColumns * tileRows, 1.0f)
+{
+}
+
+void OcclusionCuller::beginFrame(const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+{
+	viewProjection_ = viewProjection;
+	cameraPosition_ = cameraPosition;
+	frustum_ = Frustum{viewProjection};
+
+	candidates_.clear();
+	occluderCount_ = 0;
+
+	std::fill(depth_.begin(), depth_.end(), 1.0f);
+	std::fill(tileDepth_.begin(), tileDepth_.end(), 1.0f);
+}
+
+// Rank the box by the approximate size of its bounding sphere on screen, ignoring boxes that can't be seen as they can't hide anything
+void OcclusionCuller::addOccluder(const glm::vec3& min, const glm::vec3& max)
+{
+	const auto centre{(min + max) * 0.5f};
+	const auto radius{glm::distance(min, max) * 0.5f};
+	if (radius <= 0.0f || !frustum_.containsSphere(centre, radius))
+		return;
+
+	const auto distance{std::max(glm::distance(centre, cameraPosition_), radius)};
+	candidates_.push_back(Occluder{min, max, radius / distance});
+}
+
+void OcclusionCuller::rasterizeOccluders()
+{
+	occluderCount_ = std::min(static_cast<int>(candidates_.size()), MaxOccluders);
+	if (occluderCount_ == 0)
+		return;
+
+	std::partial_sort(candidates_.begin(), candidates_.begin() + occluderCount_, candidates_.end(), [](const Occluder& a, const Occluder& b)
+	{
+		return a.ScreenSize > b.ScreenSize;
+	});
+
+	for (auto i{0}; i < occluderCount_; ++i)
+		rasterizeBox(candidates_[i].Min, candidates_[i].Max);
+
+	buildTiles();
+}
+
+// A box is hidden if, in every pixel its screen bounds overlap, an occluder is nearer than the nearest corner of the box. Tiles farther than the box's nearest point are skipped whole, and tiles entirely inside the bounds and not skipped prove the box visible without looking at their pixels
+bool OcclusionCuller::isOccluded(const glm::vec3& min, const glm::vec3& max) const
+{
+	if (occluderCount_ == 0)
+		return false;
+
+	auto screenMin{glm::vec3{static_cast<float>(Width), static_cast<float>(Height), 1.0f}};
+	auto screenMax{glm::vec3{0.0f}};
+	for (auto i{0}; i < 8; ++i)
+	{
+		const auto clip{viewProjection_ * glm::vec4{getCorner(min, max, i), 1.0f}};
+		if (getNearDistance(clip) <= 0.0f)
+			return false;
+
+		const auto vertex{toScreen(clip)};
+		screenMin = glm::min(screenMin, glm::vec3{vertex.X, vertex.Y, vertex.Z});
+		screenMax = glm::max(screenMax, glm::vec3{vertex.X, vertex.Y, vertex.Z});
+	}
+
+	if (screenMax.x < 0.0f || screenMax.y < 0.0f || screenMin.x >= Width || screenMin.y >= Height)
+		return false;
+
+	// Every pixel the bounds touch, even partially
+	const auto minX{std::max(static_cast<int>(std::floor(screenMin.x)), 0)};
+	const auto minY{std::max(static_cast<int>(std::floor(screenMin.y)), 0)};
+	const auto maxX{std::min(static_cast<int>(std::floor(screenMax.x)), Width - 1)};
+	const auto maxY{std::min(static_cast<int>(std::floor(screenMax.y)), Height - 1)};
+	const auto nearestDepth{screenMin.z};
+
+	for (auto tileY{minY / TileSize}; tileY <= maxY / TileSize; ++tileY)
+	{
+		for (auto tileX{minX / TileSize}; tileX <= maxX / TileSize; ++tileX)
+		{
+			if (tileDepth_[tileY * tileColumns + tileX] < nearestDepth)
+				continue;
+
+			const auto x0{std::max(minX, tileX * TileSize)};
+			const auto y0{std::max(minY, tileY * TileSize)};
+			const auto x1{std::min(maxX, tileX * TileSize + TileSize - 1)};
+			const auto y1{std::min(maxY, tileY * TileSize + TileSize - 1)};
+			if (x1 - x0 == TileSize - 1 && y1 - y0 == TileSize - 1)
+				return false;
+
+			for (auto y{y0}; y <= y1; ++y)
+			{
+				for (auto x{x0}; x <= x1; ++x)
+				{
+					if (depth_[y * Width + x] >= nearestDepth)
+						return false;
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
+int OcclusionCuller::getOccluderCount() const
+{
+	return occluderCount_;
+}
+
+// Rasterize the box's outline on screen rather than its faces one triangle at a time, as a pixel split between two faces is covered by neither on its own. Only pixels the outline covers completely are written, each with the farthest depth the box's front faces reach within the pixel, so no pixel ever claims to be nearer than the box really is
+void OcclusionCuller::rasterizeBox(const glm::vec3& min, const glm::vec3& max)
+{
+	glm::vec4 clip[8]{};
+	for (auto i{0}; i < 8; ++i)
+		clip[i] = viewProjection_ * glm::vec4{getCorner(min, max, i), 1.0f};
+
+	// Points of the box clipped by the near plane: the corners in front of it, and the points where edges cross it
+	ScreenVertex points[maxOutlinePoints]{};
+	auto pointCount{0};
+	auto crossesNearPlane{false};
+	for (auto i{0}; i < 8; ++i)
+	{
+		const auto distance{getNearDistance(clip[i])};
+		if (distance > 0.0f)
+			points[pointCount++] = toScreen(clip[i]);
+
+		for (auto axis{1}; axis < 8; axis <<= 1)
+		{
+			if (i & axis)
+				continue;
+
+			const auto otherDistance{getNearDistance(clip[i | axis])};
+			if ((distance > 0.0f) != (otherDistance > 0.0f))
+			{
+				points[pointCount++] = toScreen(clip[i] + (clip[i | axis] - clip[i]) * (distance / (distance - otherDistance)));
+				crossesNearPlane = true;
+			}
+		}
+	}
+
+	if (pointCount < 3)
+		return;
+
+	// The box is convex, so its depth seen through any pixel is the farthest of its front faces' planes there
+	LinearFunction depthPlanes[std::size(boxFaces) + 1]{};
+	auto planeCount{0};
+	for (const auto& face : boxFaces)
+	{
+		ScreenVertex polygon[5]{};
+		auto vertexCount{0};
+		for (auto j{0}; j < 4; ++j)
+		{
+			const auto& current{clip[face[j]]};
+			const auto& next{clip[face[(j + 1) % 4]]};
+			const auto currentDistance{getNearDistance(current)};
+			const auto nextDistance{getNearDistance(next)};
+
+			if (currentDistance > 0.0f)
+				polygon[vertexCount++] = toScreen(current);
+
+			if ((currentDistance > 0.0f) != (nextDistance > 0.0f))
+				polygon[vertexCount++] = toScreen(current + (next - current) * (currentDistance / (currentDistance - nextDistance)));
+		}
+
+		// Faces seen edge on have no area, and bound the outline rather than the depth
+		auto area{0.0f};
+		auto widest{1};
+		auto widestArea{0.0f};
+		for (auto j{1}; j + 1 < vertexCount; ++j)
+		{
+			const auto triangleArea{getDoubleArea(polygon[0], polygon[j], polygon[j + 1])};
+			area += triangleArea;
+			if (triangleArea > widestArea)
+			{
+				widestArea = triangleArea;
+				widest = j;
+			}
+		}
+
+		if (area <= 0.0f || widestArea <= 0.0f)
+			continue;
+
+		// Raise the plane to its farthest point within a pixel
+		auto plane{makeDepthPlane(polygon[0], polygon[widest], polygon[widest + 1])};
+		plane.C += 0.5f * (std::abs(plane.A) + std::abs(plane.B));
+		depthPlanes[planeCount++] = plane;
+	}
+
+	// Nothing faces the camera if it is inside the box
+	if (planeCount == 0)
+		return;
+
+	// Where the near plane cuts the box, the cut is the nearest face, at a depth of 0
+	if (crossesNearPlane)
+		depthPlanes[planeCount++] = LinearFunction{};
+
+	// Convex hull of the points, anticlockwise
+	std::sort(points, points + pointCount, [](const ScreenVertex& a, const ScreenVertex& b)
+	{
+		return a.X < b.X || (a.X == b.X && a.Y < b.Y);
+	});
+
+	ScreenVertex hull[maxOutlinePoints + 1]{};
+	auto hullCount{0};
+	for (auto i{0}; i < pointCount; ++i)
+	{
+		while (hullCount >= 2 && getDoubleArea(hull[hullCount - 2], hull[hullCount - 1], points[i]) <= 0.0f)
+			--hullCount;
+		hull[hullCount++] = points[i];
+	}
+	const auto lowerCount{hullCount + 1};
+	for (auto i{pointCount - 2}; i >= 0; --i)
+	{
+		while (hullCount >= lowerCount && getDoubleArea(hull[hullCount - 2], hull[hullCount - 1], points[i]) <= 0.0f)
+			--hullCount;
+		hull[hullCount++] = points[i];
+	}
+
+	// The last point closes the hull back at the first
+	--hullCount;
+	if (hullCount < 3)
+		return;
+
+	// Lower each edge function to its value at the pixel corner farthest outside the edge, so it is only positive for pixels entirely inside
+	LinearFunction edges[maxOutlinePoints]{};
+	auto maxDepth{0.0f};
+	auto outlineMin{glm::vec2{hull[0].X, hull[0].Y}};
+	auto outlineMax{outlineMin};
+	for (auto i{0}; i < hullCount; ++i)
+	{
+		auto edge{makeEdge(hull[i], hull[(i + 1) % hullCount])};
+		edge.C -= 0.5f * (std::abs(edge.A) + std::abs(edge.B));
+		edges[i] = edge;
+
+		maxDepth = std::max(maxDepth, hull[i].Z);
+		outlineMin = glm::min(outlineMin, glm::vec2{hull[i].X, hull[i].Y});
+		outlineMax = glm::max(outlineMax, glm::vec2{hull[i].X, hull[i].Y});
+	}
+
+	// Points inside the outline lie between the box's vertices, so can't be farther than the farthest of them. Points behind the near plane were dropped from the hull, but not from the points depth is bounded by
+	for (auto i{0}; i < pointCount; ++i)
+		maxDepth = std::max(maxDepth, points[i].Z);
+
+	rasterizeOutline(edges, hullCount, depthPlanes, planeCount, maxDepth, outlineMin, outlineMax);
+}
+
+// Evaluate the outline's edge functions and the depth planes at the centres of a block of pixels at once, keeping the nearer of the stored and box depths in pixels inside every edge
+void OcclusionCuller::rasterizeOutline(const LinearFunction* edges, int edgeCount, const LinearFunction* depthPlanes, int planeCount, float maxDepth, const glm::vec2& outlineMin, const glm::vec2& outlineMax)
+{
+	// Pixels lying entirely within the outline's bounds, with the first column aligned to the SIMD block
+	const auto minX{std::max(static_cast<int>(std::ceil(outlineMin.x)), 0) / laneCount * laneCount};
+	const auto minY{std::max(static_cast<int>(std::ceil(outlineMin.y)), 0)};
+	const auto maxX{std::min(static_cast<int>(std::floor(outlineMax.x)) - 1, Width - 1)};
+	const auto maxY{std::min(static_cast<int>(std::floor(outlineMax.y)) - 1, Height - 1)};
+	if (minX > maxX || minY > maxY)
+		return;
+
+	for (auto y{minY}; y <= maxY; ++y)
+	{
+		const auto centreY{static_cast<float>(y) + 0.5f};
+		auto* row{&depth_[y * Width]};
+		auto x{minX};
+
+#if defined(__AVX2__)
+		const auto laneOffsets{_mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f)};
+		const auto zero{_mm256_setzero_ps()};
+		const auto farthest{_mm256_set1_ps(maxDepth)};
+
+		for (; x <= maxX; x += 8)
+		{
+			const auto centreX{_mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets)};
+
+			auto inside{_mm256_castsi256_ps(_mm256_set1_epi32(-1))};
+			for (auto i{0}; i < edgeCount; ++i)
+			{
+				const auto distance{_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(edges[i].A), centreX), _mm256_set1_ps(edges[i].B * centreY + edges[i].C))};
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+			}
+
+			auto depth{_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(depthPlanes[0].A), centreX), _mm256_set1_ps(depthPlanes[0].B * centreY + depthPlanes[0].C))};
+			for (auto i{1}; i < planeCount; ++i)
+				depth = _mm256_max_ps(depth, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(depthPlanes[i].A), centreX), _mm256_set1_ps(depthPlanes[i].B * centreY + depthPlanes[i].C)));
+			depth = _mm256_min_ps(depth, farthest);
+
+			const auto stored{_mm256_loadu_ps(row + x)};
+			_mm256_storeu_ps(row + x, _mm256_blendv_ps(stored, _mm256_min_ps(stored, depth), inside));
+		}
+#elif defined(OCCLUSION_SSE2)
+		const auto laneOffsets{_mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f)};
+		const auto zero{_mm_setzero_ps()};
+		const auto farthest{_mm_set1_ps(maxDepth)};
+
+		for (; x <= maxX; x += 4)
+		{
+			const auto centreX{_mm_add_ps(_mm_set1_ps(static_cast<float>(x)), laneOffsets)};
+
+			auto inside{_mm_castsi128_ps(_mm_set1_epi32(-1))};
+			for (auto i{0}; i < edgeCount; ++i)
+			{
+				const auto distance{_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edges[i].A), centreX), _mm_set1_ps(edges[i].B * centreY + edges[i].C))};
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+			}
+
+			auto depth{_mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthPlanes[0].A), centreX), _mm_set1_ps(depthPlanes[0].B * centreY + depthPlanes[0].C))};
+			for (auto i{1}; i < planeCount; ++i)
+				depth = _mm_max_ps(depth, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(depthPlanes[i].A), centreX), _mm_set1_ps(depthPlanes[i].B * centreY + depthPlanes[i].C)));
+			depth = _mm_min_ps(depth, farthest);
+
+			// SSE2 has no blend, so select with masks
+			const auto stored{_mm_loadu_ps(row + x)};
+			_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(stored, depth)), _mm_andnot_ps(inside, stored)));
+		}
+#endif
+
+		for (; x <= maxX; ++x)
+		{
+			const auto centreX{static_cast<float>(x) + 0.5f};
+			const auto inside{std::all_of(edges, edges + edgeCount, [centreX, centreY](const LinearFunction& edge)
+			{
+				return edge.A * centreX + edge.B * centreY + edge.C >= 0.0f;
+			})};
+
+			if (!inside)
+				continue;
+
+			auto depth{depthPlanes[0].A * centreX + depthPlanes[0].B * centreY + depthPlanes[0].C};
+			for (auto i{1}; i < planeCount; ++i)
+				depth = std::max(depth, depthPlanes[i].A * centreX + depthPlanes[i].B * centreY + depthPlanes[i].C);
+
+			row[x] = std::min(row[x], std::min(depth, maxDepth));
+		}
+	}
+}
+
+// Keep the farthest depth in each tile, so an object nearer than a tile's depth is in front of everything drawn in the tile
+void OcclusionCuller::buildTiles()
+{
+	for (auto tileY{0}; tileY < tileRows; ++tileY)
+	{
+		for (auto tileX{0}; tileX < tileColumns; ++tileX)
+		{
+			auto farthest{0.0f};
+			for (auto y{tileY * TileSize}; y < (tileY + 1) * TileSize; ++y)
+			{
+				const auto* row{&depth_[y * Width + tileX * TileSize]};
+				farthest = std::max(farthest, *std::max_element(row, row + TileSize));
+			}
+
+			tileDepth_[tileY * tileColumns + tileX] = farthest;
+		}
+	}
+}
+
+// Perspective divide, then map x and y from normalised device coordinates to pixels and depth to the range 0 to 1
+OcclusionCuller::ScreenVertex OcclusionCuller::toScreen(const glm::vec4& clip)
+{
+	const auto ndc{glm::vec3{clip} / clip.w};
+
+	return ScreenVertex{(ndc.x * 0.5f + 0.5f) * Width, (ndc.y * 0.5f + 0.5f) * Height, ndc.z * 0.5f + 0.5f};
+}
+
+// Twice the signed area of the triangle, positive when it is wound anticlockwise
+float OcclusionCuller::getDoubleArea(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+{
+	return (v1.X - v0.X) * (v2.Y - v0.Y) - (v1.Y - v0.Y) * (v2.X - v0.X);
+}
+
+// Edge function of the edge from a to b, positive on the left of the edge, which is the inside of an anticlockwise polygon
+OcclusionCuller::LinearFunction OcclusionCuller::makeEdge(const ScreenVertex& a, const ScreenVertex& b)
+{
+	const auto edgeA{a.Y - b.Y};
+	const auto edgeB{b.X - a.X};
+
+	return LinearFunction{edgeA, edgeB, -(edgeA * a.X + edgeB * a.Y)};
+}
+
+// Depth plane through an anticlockwise triangle, its gradient from the vertex depths weighted by the edge function opposite each vertex. The constant is taken from a vertex, as weighting the edge functions' constants loses most of its precision to cancellation
+OcclusionCuller::LinearFunction OcclusionCuller::makeDepthPlane(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2)
+{
+	const auto area{getDoubleArea(v0, v1, v2)};
+	const LinearFunction edges[]{makeEdge(v1, v2), makeEdge(v2, v0), makeEdge(v0, v1)};
+
+	const auto a{(edges[0].A * v0.Z + edges[1].A * v1.Z + edges[2].A * v2.Z) / area};
+	const auto b{(edges[0].B * v0.Z + edges[1].B * v1.Z + edges[2].B * v2.Z) / area};
+
+	return LinearFunction{a, b, v0.Z - a * v0.X - b * v0.Y};
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frustum.h"
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+// Class hiding objects behind large solid boxes, such as platforms, without any help from the GPU. Each frame the boxes covering the most of the screen are rasterized into a low resolution depth buffer with SIMD instructions, and the farthest depth of each tile of the buffer is kept as a coarser level. Objects are then tested against the tiles their screen bounds overlap, falling back to individual pixels only for tiles the coarse test can't decide.
+class OcclusionCuller
+{
+public:
+	OcclusionCuller();
+
+	// Clear the depth buffer and candidate occluders for a frame seen through viewProjection from cameraPosition
+	void beginFrame(const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+	// Offer a box as an occluder for this frame. The box must be completely solid, as everything behind its faces is treated as hidden
+	void addOccluder(const glm::vec3& min, const glm::vec3& max);
+
+	// Rasterize the candidate occluders that cover the most of the screen, then build the tile level of the depth buffer
+	void rasterizeOccluders();
+
+	// Whether the box is certainly hidden behind the occluders rasterized this frame. Boxes crossing the near plane or off the screen are never reported hidden
+	bool isOccluded(const glm::vec3& min, const glm::vec3& max) const;
+
+	// Number of occluders rasterized this frame
+	int getOccluderCount() const;
+
+	// Resolution of the depth buffer. Independent of the window's resolution, so pixels aren't square unless the window's aspect ratio matches
+	static constexpr int Width{256};
+	static constexpr int Height{144};
+
+	// Size of the square tiles making up the coarse level of the depth buffer
+	static constexpr int TileSize{8};
+
+	// Maximum number of occluders rasterized per frame
+	static constexpr int MaxOccluders{8};
+
+private:
+	struct Occluder
+	{
+		glm::vec3 Min{};
+		glm::vec3 Max{};
+		float ScreenSize{};
+	};
+
+	// Vertex position in the depth buffer, in pixels from the bottom left, with depth from 0 at the near plane to 1 at the far plane
+	struct ScreenVertex
+	{
+		float X{};
+		float Y{};
+		float Z{};
+	};
+
+	// Linear function of a position in the depth buffer, A * x + B * y + C, used both for the edges of shapes and for depth
+	struct LinearFunction
+	{
+		float A{};
+		float B{};
+		float C{};
+	};
+
+	glm::mat4 viewProjection_;
+	glm::vec3 cameraPosition_;
+	Frustum frustum_;
+
+	std::vector<Occluder> candidates_;
+	int occluderCount_;
+
+	// Nearest occluder depth of each pixel, with rows from the bottom of the screen, and farthest depth of each tile
+	std::vector<float> depth_;
+	std::vector<float> tileDepth_;
+
+	void rasterizeBox(const glm::vec3& min, const glm::vec3& max);
+	void rasterizeOutline(const LinearFunction* edges, int edgeCount, const LinearFunction* depthPlanes, int planeCount, float maxDepth, const glm::vec2& outlineMin, const glm::vec2& outlineMax);
+	void buildTiles();
+
+	static ScreenVertex toScreen(const glm::vec4& clip);
+	static float getDoubleArea(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+	static LinearFunction makeEdge(const ScreenVertex& a, const ScreenVertex& b);
+	static LinearFunction makeDepthPlane(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2);
+};
@@ -1,10 +1,18 @@
 #include "platform.h"
-#include <GLFW/glfw3.h>
 #include "effolkronium/random.hpp"
+#include <cmath>
+#include <utility>
 
-Platform::Platform(const Model& model, const Shader& shader, const glm::vec3& position, const glm::vec3& size, bool oscillate, const glm::vec3& offset, const glm::vec3& scale)
-	: VisibleObject{model, shader, position, size, offset, scale},
+namespace
+{
+	// Game time that passes each tick, given the fixed update rate of sixty updates per second
+	constexpr auto tickDuration{1.0f / 60.0f};
+}
+
+Platform::Platform(std::shared_ptr<const Model> model, const Shader& shader, const glm::vec3& position, const glm::vec3& size, bool oscillate, const glm::vec3& offset, const glm::vec3& scale)
+	: VisibleObject{std::move(model), shader, position, size, offset, scale},
 	offset_{effolkronium::random_thread_local::get<float>(1, 10)},
+	time_{0.0f},
 	oscillate_{oscillate}
 {
 }
@@ -15,9 +23,12 @@ void Platform::init()
 
 void Platform::tick(float deltaTime)
 {
+	// Oscillation is driven by time counted in ticks rather than read from the clock, so platforms move identically however ticks are scheduled
+	time_ += tickDuration;
+
 	if (oscillate_)
 	{
-		const auto y{sin(static_cast<float>(glfwGetTime())) * 0.0025f * offset_ * deltaTime};
+		const auto y{std::sin(time_) * 0.0025f * offset_ * deltaTime};
 
 		addVelocity(glm::vec3{0.0f, y, 0.0f});
 
@@ -25,6 +36,23 @@ void Platform::tick(float deltaTime)
 	}
 }
 
+bool Platform::isStatic() const
+{
+	return !oscillate_;
+}
+
+// The platform model is a flat disc on top of a hemisphere. A box spanning the middle half of the model's width and depth and the top half of its height lies inside the dome, with room to spare for the hemisphere being built from flat faces
+bool Platform::getOccluderBounds(glm::vec3& min, glm::vec3& max) const
+{
+	const auto& bounds{getModel().getBounds()};
+	const auto centre{(bounds.Min + bounds.Max) * 0.5f};
+	const auto extent{(bounds.Max - bounds.Min) * 0.25f};
+
+	transformBounds(glm::vec3{centre.x - extent.x, centre.y, centre.z - extent.z}, glm::vec3{centre.x + extent.x, bounds.Max.y, centre.z + extent.z}, min, max);
+
+	return true;
+}
+
 void Platform::setOscillate(bool oscillate)
 {
 	oscillate_ = oscillate;
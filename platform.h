@@ -5,16 +5,23 @@
 class Platform : public VisibleObject
 {
 public:
-	Platform(const Model& model, const Shader& shader, const glm::vec3& position, const glm::vec3& size, bool oscillate = true, const glm::vec3& offset = glm::vec3{0.0}, const glm::vec3& scale = glm::vec3{1.0});
+	Platform(std::shared_ptr<const Model> model, const Shader& shader, const glm::vec3& position, const glm::vec3& size, bool oscillate = true, const glm::vec3& offset = glm::vec3{0.0}, const glm::vec3& scale = glm::vec3{1.0});
 
 	virtual void init() override;
 
 	virtual void tick(float deltaTime) override;
 
+	// Platforms that don't oscillate never move
+	virtual bool isStatic() const override;
+
+	// Platforms are drawn as solid domes, so the box is fitted inside the dome rather than taken from the collision box, which the dome only partly fills
+	virtual bool getOccluderBounds(glm::vec3& min, glm::vec3& max) const override;
+
 	void setOscillate(bool oscillate);
 	bool getOscillate() const;
 
 private:
 	float offset_;
+	float time_;
 	bool oscillate_;
 };
@@ -0,0 +1,130 @@
+#include "renderqueue.h"
+#include "mesh.h"
+#include "shader.h"
+#include <algorithm>
+
+RenderQueue::RenderQueue() : packets_{}, commands_{}, commandBuffer_{}, drawCount_{0}, stateChangeCount_{0}
+{
+}
+
+void RenderQueue::push(RenderPass pass, const Shader& shader, const Mesh& mesh, int lod, int baseInstance, int instanceCount)
+{
+	const auto key{makeKey(pass, shader.getId(), mesh.getMaterialId(), mesh.getGeometry().Vao)};
+	packets_.push_back(DrawPacket{key, &shader, &mesh, lod, baseInstance, instanceCount});
+}
+
+// Draw packets in key order, tracking the bound program, material, and vertex array so each is only bound when it changes
+void RenderQueue::submit(unsigned int instanceBuffer)
+{
+	drawCount_ = 0;
+	stateChangeCount_ = 0;
+
+	if (packets_.empty())
+		return;
+
+	std::sort(packets_.begin(), packets_.end(), [](const DrawPacket& a, const DrawPacket& b)
+	{
+		return a.Key < b.Key;
+	});
+
+	// Write a command for every packet up front, so the whole frame's commands are uploaded at once
+	commands_.clear();
+	for (const auto& packet : packets_)
+	{
+		const auto& geometry{packet.PacketMesh->getGeometry()};
+		const auto& indices{geometry.Lods[packet.Lod]};
+		commands_.push_back(DrawElementsIndirectCommand
+		{
+			static_cast<unsigned int>(indices.IndexCount),
+			static_cast<unsigned int>(packet.InstanceCount),
+			static_cast<unsigned int>(indices.FirstIndex),
+			geometry.BaseVertex,
+			static_cast<unsigned int>(packet.BaseInstance)
+		});
+	}
+
+	// Buffer can't be created until there is an OpenGL context, so create it on first use
+	if (commandBuffer_.get() == 0)
+	{
+		unsigned int buffer{};
+		glGenBuffers(1, &buffer);
+		commandBuffer_ = BufferHandle{buffer};
+	}
+
+	const auto commandBytes{static_cast<long long>(commands_.size() * sizeof(DrawElementsIndirectCommand))};
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_.get());
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commandBytes, commands_.data(), GL_STREAM_DRAW);
+	commandBuffer_.setBytes(commandBytes);
+
+	// Zero is never a valid material or vertex array name, so nothing is assumed to be bound at the start
+	unsigned int boundProgram{0};
+	unsigned int boundMaterial{0};
+	unsigned int boundVao{0};
+
+	const auto count{static_cast<int>(packets_.size())};
+	for (auto first{0}; first < count;)
+	{
+		const auto& shader{*packets_[first].PacketShader};
+		const auto& mesh{*packets_[first].PacketMesh};
+		const auto vao{mesh.getGeometry().Vao};
+
+		// Find the run of packets sharing this packet's state, which can all be drawn with one call. Commands in a multi-draw execute in order, so a run may span passes
+		auto last{first + 1};
+		while (last < count && packets_[last].PacketShader->getId() == shader.getId() && packets_[last].PacketMesh->getMaterialId() == mesh.getMaterialId() && packets_[last].PacketMesh->getGeometry().Vao == vao)
+			++last;
+
+		if (shader.getId() != boundProgram)
+		{
+			shader.use();
+			boundProgram = shader.getId();
+			++stateChangeCount_;
+		}
+
+		// Texture bindings belong to the context rather than the program, so they survive program changes
+		if (mesh.getMaterialId() != boundMaterial)
+		{
+			mesh.bindTextures();
+			boundMaterial = mesh.getMaterialId();
+			++stateChangeCount_;
+		}
+
+		// Instance data is addressed through the base instance, so the instance buffer only needs attaching when the vertex array changes. Each vertex array holds a single index type, so a run never mixes index types
+		if (vao != boundVao)
+		{
+			glBindVertexArray(vao);
+			glBindVertexBuffer(GeometryManager::InstanceBinding, instanceBuffer, 0, sizeof(InstanceData));
+			boundVao = vao;
+			++stateChangeCount_;
+		}
+
+		glMultiDrawElementsIndirect(GL_TRIANGLES, mesh.getGeometry().IndexType, reinterpret_cast<const void*>(first * sizeof(DrawElementsIndirectCommand)), last - first, 0);
+		++drawCount_;
+
+		first = last;
+	}
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glActiveTexture(GL_TEXTURE0);
+
+	packets_.clear();
+}
+
+int RenderQueue::getDrawCount() const
+{
+	return drawCount_;
+}
+
+int RenderQueue::getStateChangeCount() const
+{
+	return stateChangeCount_;
+}
+
+std::uint64_t RenderQueue::makeKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int vao)
+{
+	constexpr std::uint64_t programMask{(1u << 16) - 1};
+	constexpr std::uint64_t materialMask{(1u << 20) - 1};
+	constexpr std::uint64_t vaoMask{(1u << 24) - 1};
+
+	return static_cast<std::uint64_t>(pass) << 60 | (program & programMask) << 44 | (material & materialMask) << 24 | (vao & vaoMask);
+}
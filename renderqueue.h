@@ -0,0 +1,61 @@
+#pragma once
+
+#include "gpuresource.h"
+#include <cstdint>
+#include <vector>
+
+class Mesh;
+class Shader;
+
+// Passes are drawn in the order they are declared
+enum class RenderPass
+{
+	OPAQUE
+};
+
+// Class collecting the draw calls for a frame as packets with 64-bit sort keys, built from pass, shader program, material, and vertex array. Packets are sorted by key before being submitted, so draws sharing state are adjacent and binds that wouldn't change anything can be skipped. Each run of packets sharing all state is issued as a single multi-draw call, reading its draws from an indirect command buffer built each frame.
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// Queue an instanced draw of a mesh's level of detail, reading instanceCount instances from the instance buffer starting at baseInstance
+	void push(RenderPass pass, const Shader& shader, const Mesh& mesh, int lod, int baseInstance, int instanceCount);
+
+	// Sort and draw all queued packets, sourcing per-instance data from instanceBuffer, then clear the queue
+	void submit(unsigned int instanceBuffer);
+
+	// Number of multi-draw calls and of program, texture, and vertex array binds made by the last submit
+	int getDrawCount() const;
+	int getStateChangeCount() const;
+
+private:
+	struct DrawPacket
+	{
+		std::uint64_t Key{};
+		const Shader* PacketShader{};
+		const Mesh* PacketMesh{};
+		int Lod{};
+		int BaseInstance{};
+		int InstanceCount{};
+	};
+
+	// Layout of a command read by glMultiDrawElementsIndirect
+	struct DrawElementsIndirectCommand
+	{
+		unsigned int Count{};
+		unsigned int InstanceCount{};
+		unsigned int FirstIndex{};
+		int BaseVertex{};
+		unsigned int BaseInstance{};
+	};
+
+	std::vector<DrawPacket> packets_;
+	std::vector<DrawElementsIndirectCommand> commands_;
+	BufferHandle commandBuffer_;
+	int drawCount_;
+	int stateChangeCount_;
+
+	// Key is laid out, most significant first, as 4 bits of pass, 16 bits of program, 20 bits of material, and 24 bits of vertex array
+	static std::uint64_t makeKey(RenderPass pass, unsigned int program, unsigned int material, unsigned int vao);
+};
@@ -2,8 +2,20 @@
 #include <glm/mat4x4.hpp>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// Material texture types in the order their texture units are allocated, each type being given a contiguous range of units
+	const std::string textureTypes[]{"texture_diffuse", "texture_specular", "texture_normal", "texture_height"};
+
+	// Maximum value of N in a sampler named "texture_<type>N"
+	constexpr auto maxSamplerNumber{4};
+}
 
 Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath, const std::string& geometryPath)
 {
@@ -80,12 +92,14 @@ Shader::Shader(const std::string& vertexPath, const std::string& fragmentPath, c
 
 	// Link compiled shaders into shader program
 	Id = glCreateProgram();
+	Program = std::make_shared<ProgramHandle>(Id);
 	glAttachShader(Id, vertex);
 	glAttachShader(Id, fragment);
 	if (!geometryPath.empty())
 		glAttachShader(Id, geometry);
 	glLinkProgram(Id);
 	checkShaderErrors(Id, "PROGRAM");
+	cacheUniforms();
 
 	// Cleanup
 	glDeleteShader(vertex);
@@ -99,64 +113,178 @@ void Shader::use() const
 	glUseProgram(Id);
 }
 
+int Shader::getUniformLocation(const std::string& name) const
+{
+	const auto found{UniformLocations->find(name)};
+	return found != UniformLocations->end() ? found->second : -1;
+}
+
+void Shader::setUniform(int location, bool value) const
+{
+	glUniform1i(location, static_cast<int>(value));
+}
+
+void Shader::setUniform(int location, int value) const
+{
+	glUniform1i(location, value);
+}
+
+void Shader::setUniform(int location, float value) const
+{
+	glUniform1f(location, value);
+}
+
+void Shader::setUniform(int location, const glm::vec2& value) const
+{
+	glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, const glm::vec3& value) const
+{
+	glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, const glm::vec4& value) const
+{
+	glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::setUniform(int location, const glm::mat2& value) const
+{
+	glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int location, const glm::mat3& value) const
+{
+	glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::setUniform(int location, const glm::mat4& value) const
+{
+	glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
 void Shader::setUniform(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(Id, name.c_str()), static_cast<int>(value));
+	glUniform1i(getUniformLocation(name), static_cast<int>(value));
 }
 
 void Shader::setUniform(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(Id, name.c_str()), value);
+	glUniform1i(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(Id, name.c_str()), value);
+	glUniform1f(getUniformLocation(name), value);
 }
 
 void Shader::setUniform(const std::string& name, const glm::vec2& value) const
 {
-	glUniform2fv(glGetUniformLocation(Id, name.c_str()), 1, &value[0]);
+	glUniform2fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setUniform(const std::string& name, float x, float y) const
 {
-	glUniform2f(glGetUniformLocation(Id, name.c_str()), x, y);
+	glUniform2f(getUniformLocation(name), x, y);
 }
 
 void Shader::setUniform(const std::string& name, const glm::vec3& value) const
 {
-	glUniform3fv(glGetUniformLocation(Id, name.c_str()), 1, &value[0]);
+	glUniform3fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setUniform(const std::string& name, float x, float y, float z) const
 {
-	glUniform3f(glGetUniformLocation(Id, name.c_str()), x, y, z);
+	glUniform3f(getUniformLocation(name), x, y, z);
 }
 
 void Shader::setUniform(const std::string& name, const glm::vec4& value) const
 {
-	glUniform4fv(glGetUniformLocation(Id, name.c_str()), 1, &value[0]);
+	glUniform4fv(getUniformLocation(name), 1, &value[0]);
 }
 
 void Shader::setUniform(const std::string& name, float x, float y, float z, float w) const
 {
-	glUniform4f(glGetUniformLocation(Id, name.c_str()), x, y, z, w);
+	glUniform4f(getUniformLocation(name), x, y, z, w);
 }
 
 void Shader::setUniform(const std::string& name, const glm::mat2& value) const
 {
-	glUniformMatrix2fv(glGetUniformLocation(Id, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	glUniformMatrix2fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
 }
 
 void Shader::setUniform(const std::string& name, const glm::mat3& value) const
 {
-	glUniformMatrix3fv(glGetUniformLocation(Id, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	glUniformMatrix3fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
 }
 
 void Shader::setUniform(const std::string& name, const glm::mat4& value) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(Id, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]);
+}
+
+// Sampler units are allocated as a block of maxSamplerNumber units per texture type, so "texture_specular2" is always unit maxSamplerNumber + 1
+int Shader::getTextureUnit(const std::string& samplerName)
+{
+	for (auto type{0}; type < static_cast<int>(std::size(textureTypes)); ++type)
+	{
+		const auto& prefix{textureTypes[type]};
+		if (samplerName.size() != prefix.size() + 1 || samplerName.compare(0, prefix.size(), prefix) != 0)
+			continue;
+
+		const auto number{samplerName.back() - '0'};
+		if (number < 1 || number > maxSamplerNumber)
+			return -1;
+
+		return type * maxSamplerNumber + number - 1;
+	}
+
+	return -1;
+}
+
+// Reflect over the linked program's active uniforms, so uniform names never need to be resolved while rendering
+void Shader::cacheUniforms()
+{
+	std::unordered_map<std::string, int> locations{};
+
+	int uniformCount{};
+	int maxNameLength{};
+	glGetProgramInterfaceiv(Id, GL_UNIFORM, GL_ACTIVE_RESOURCES, &uniformCount);
+	glGetProgramInterfaceiv(Id, GL_UNIFORM, GL_MAX_NAME_LENGTH, &maxNameLength);
+
+	std::vector<char> nameBuffer(static_cast<std::size_t>(maxNameLength) + 1);
+	constexpr GLenum properties[]{GL_LOCATION};
+
+	glUseProgram(Id);
+	for (auto i{0}; i < uniformCount; ++i)
+	{
+		int location{};
+		glGetProgramResourceiv(Id, GL_UNIFORM, i, 1, properties, 1, nullptr, &location);
+
+		// Members of uniform blocks have no location and are set through their buffer instead
+		if (location < 0)
+			continue;
+
+		int nameLength{};
+		glGetProgramResourceName(Id, GL_UNIFORM, i, static_cast<int>(nameBuffer.size()), &nameLength, nameBuffer.data());
+		auto name{std::string{nameBuffer.data(), static_cast<std::size_t>(nameLength)}};
+
+		// Arrays are reported by their first element, but are usually referred to without the subscript
+		constexpr auto arraySuffix{"[0]"};
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, arraySuffix) == 0)
+			name.resize(name.size() - 3);
+
+		// Samplers following the material naming convention are fixed to a texture unit, so meshes can bind textures without setting uniforms
+		const auto unit{getTextureUnit(name)};
+		if (unit >= 0)
+			glUniform1i(location, unit);
+
+		locations.emplace(std::move(name), location);
+	}
+	glUseProgram(0);
+
+	UniformLocations = std::make_shared<const std::unordered_map<std::string, int>>(std::move(locations));
 }
 
 void Shader::checkShaderErrors(const GLuint& shader, const std::string& type)
@@ -1,11 +1,14 @@
 #pragma once
 
+#include "gpuresource.h"
 #include <glad/glad.h>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec4.hpp>
 #include <glm/fwd.hpp>
+#include <memory>
 #include <string>
+#include <unordered_map>
 
 // Class representing a shader program composed of a vertex and fragment shader, and optionally a geometry shader. Handles loading, compiling, and linking shader code from file, setting uniform values, and activating the shader program for use. Declaration and implementation code is based on example provided by LearnOpenGL.com - source: https://learnopengl.com/Getting-started/Shaders
 class Shader
@@ -17,7 +20,21 @@ public:
 	// Active the shader for use -- shader must be active before setting uniform values
 	void use() const;
 
-	// Utility functions to set shader uniform values
+	// Get the location of a uniform, resolved once when the program was linked. Returns -1 if the program has no active uniform with the name
+	int getUniformLocation(const std::string& name) const;
+
+	// Utility functions to set shader uniform values at a location retrieved from getUniformLocation -- each is a single GL call
+	void setUniform(int location, bool value) const;
+	void setUniform(int location, int value) const;
+	void setUniform(int location, float value) const;
+	void setUniform(int location, const glm::vec2& value) const;
+	void setUniform(int location, const glm::vec3& value) const;
+	void setUniform(int location, const glm::vec4& value) const;
+	void setUniform(int location, const glm::mat2& value) const;
+	void setUniform(int location, const glm::mat3& value) const;
+	void setUniform(int location, const glm::mat4& value) const;
+
+	// Utility functions to set shader uniform values by name, looking up the cached location
 	void setUniform(const std::string& name, bool value) const;
 	void setUniform(const std::string& name, int value) const;
 	void setUniform(const std::string& name, float value) const;
@@ -37,9 +54,19 @@ public:
 		return Id;
 	}
 
+	// Get the texture unit a material sampler named "texture_<type>N" is fixed to in every program, or -1 if the name doesn't follow the convention
+	static int getTextureUnit(const std::string& samplerName);
+
 private:
 	unsigned int Id;
 
+	// Owner of the program and its uniform locations, shared by copies of the shader so copying one is cheap and the program is deleted once the last copy is destroyed
+	std::shared_ptr<ProgramHandle> Program;
+	std::shared_ptr<const std::unordered_map<std::string, int>> UniformLocations;
+
+	// Query the program for its active uniforms and store their locations, and point material samplers at their fixed texture units
+	void cacheUniforms();
+
 	// Check for shader compilation and linking errors 
 	static void checkShaderErrors(const GLuint& shader, const std::string& type);
 };
@@ -9,36 +9,38 @@ out vec4 FragColor;
 // Only diffuse textures are supported at present
 uniform sampler2D texture_diffuse1;
 
-// Direction light
-uniform struct Light
+// Camera and lighting data shared by all programs, written once per frame
+layout (std140, binding = 0) uniform Frame
 {
-	vec4 position; // Only direction is needed for directional lights
-	vec3 color;
-} light;
+	mat4 projection;
+	mat4 view;
+	vec4 lightPosition; // Light position in view space; w of 0 makes it a direction
+	vec3 lightColor;
+};
 
 void main()
 {
 	// Calculate ambient component
 	const float ambientStrength = 0.1;
-	const vec3 ambient = ambientStrength * light.color;
+	const vec3 ambient = ambientStrength * lightColor;
 
 	// Calculate diffuse component
 	const vec3 norm = normalize(Normal);
 
 	// If light has non-zero w component, it's a position, so get the direction between it and the fragment; otherwise just take direction from the light
 	vec3 lightDir = vec3(0.0);
-	if (light.position.w == 1.0)
+	if (lightPosition.w == 1.0)
 	{
-		lightDir = normalize(vec3(light.position) - FragPos);
+		lightDir = normalize(vec3(lightPosition) - FragPos);
 	}
-	else if (light.position.w == 0.0)
+	else if (lightPosition.w == 0.0)
 	{
-		lightDir = vec3(normalize(-light.position));
+		lightDir = vec3(normalize(-lightPosition));
 	}
 
 	// Direction is defined as from light to frag, but this algo expects the opposite, so swap it
 	const float difference = max(dot(norm, lightDir), 0.0);
-	const vec3 diffuse = difference * light.color;
+	const vec3 diffuse = difference * lightColor;
 
 	// Calculate specular componet
 	const float shiniess = 4;
@@ -46,7 +48,7 @@ void main()
 	const vec3 viewDir = vec3(normalize(-FragPos));
 	const vec3 reflectDir = reflect(-lightDir, norm);
 	const float spec = pow(max(dot(viewDir, reflectDir), 0.0), shiniess);
-	const vec3 specular = specularStrength * spec * light.color;
+	const vec3 specular = specularStrength * spec * lightColor;
 
 	// Combine Phong components
 	const vec3 result = (ambient + diffuse + specular) * vec3(texture(texture_diffuse1, TexCoords));
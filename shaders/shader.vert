@@ -3,25 +3,32 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 5) in mat4 aModel; // Per-instance model matrix, occupies locations 5 to 8
+layout (location = 9) in mat3 aNormalMatrix; // Per-instance normal matrix (world space), occupies locations 9 to 11
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Camera and lighting data shared by all programs, written once per frame
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 projection;
+	mat4 view;
+	vec4 lightPosition; // Light position in view space; w of 0 makes it a direction
+	vec3 lightColor;
+};
 
 void main()
 {
 	// Pre-cache the model view matrix for subsequent operations
-	const mat4 modelView = view * model;
+	const mat4 modelView = view * aModel;
 
 	// Convert fragment position to view space before passing it through
 	FragPos = vec3(modelView * vec4(aPos, 1.0));
 
-	// Convert normal to view space using normal matrix
-	Normal = transpose(inverse(mat3(modelView))) * aNormal; // Slow, needs to be refactored out of the shader
+	// Convert normal to world space using the normal matrix calculated on the CPU, then to view space. The view matrix only rotates and translates, so its upper 3x3 transforms normals correctly
+	Normal = mat3(view) * (aNormalMatrix * aNormal);
 
 	TexCoords = aTexCoords;
 
@@ -1,17 +1,13 @@
 #version 460 core
 
-in vec2 TexCoords;
-in vec3 Normal;
-in vec4 FragPos;
+in vec3 TexCoords;
 
 out vec4 FragColor;
 
-// Only diffuse textures are supported at present
-uniform sampler2D texture_diffuse1;
-
-uniform vec3 viewPos;
+// Bound to a fixed unit, see Skybox::TextureUnit
+layout (binding = 0) uniform samplerCube skybox;
 
 void main()
 {
-	FragColor = texture(texture_diffuse1, TexCoords);
+	FragColor = texture(skybox, TexCoords);
 }
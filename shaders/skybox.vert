@@ -1,18 +1,26 @@
 #version 460 core
 
 layout (location = 0) in vec3 aPos;
-layout (location = 2) in vec2 aTexCoords;
 
-out vec2 TexCoords;
+out vec3 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Camera and lighting data shared by all programs, written once per frame
+layout (std140, binding = 0) uniform Frame
+{
+	mat4 projection;
+	mat4 view;
+	vec4 lightPosition; // Light position in view space; w of 0 makes it a direction
+	vec3 lightColor;
+};
 
 void main()
 {
-	TexCoords = aTexCoords;
+	// Sample the cubemap in the direction of the vertex from the cube's centre
+	TexCoords = aPos;
+
+	// Remove the view's translation so the cube stays centred on the camera
+	const vec4 position = projection * mat4(mat3(view)) * vec4(aPos, 1.0);
 
-	// Convert vertex position to uniform device coords
-	gl_Position = projection * view * model * vec4(aPos, 1.0);
+	// Set z to w so depth is always at the far plane after the perspective divide
+	gl_Position = position.xyww;
 }
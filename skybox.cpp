@@ -0,0 +1,150 @@
+#include "skybox.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	// How a face's texels are arranged within its cell of the cross, relative to the orientation OpenGL expects for the face
+	enum class CellRotation
+	{
+		NONE,
+		QUARTER,       // Face texel (x, y) is at cell texel (size - 1 - y, x)
+		THREE_QUARTER  // Face texel (x, y) is at cell texel (y, size - 1 - x)
+	};
+
+	// Position of a face in the cross, in whole faces from the left and from the first row of the cross as loaded
+	struct CrossFace
+	{
+		int Column{};
+		int Row{};
+		CellRotation Rotation{};
+	};
+
+	// Layout of the sky texture, in OpenGL's face order of +X, -X, +Y, -Y, +Z, -Z. Matches the texture coordinates of the sky cube model it was authored for. Images are flipped on load (see main), so rows count up from the bottom of the image
+	constexpr CrossFace crossFaces[]
+	{
+		{1, 1, CellRotation::NONE},
+		{3, 1, CellRotation::NONE},
+		{1, 0, CellRotation::QUARTER},
+		{1, 2, CellRotation::THREE_QUARTER},
+		{0, 1, CellRotation::NONE},
+		{2, 1, CellRotation::NONE}
+	};
+
+	// Positions of a unit cube's triangles. Texture coordinates are the positions themselves, the direction to sample the cubemap in
+	constexpr float cubeVertices[]
+	{
+		-1.0f,  1.0f, -1.0f,  -1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,   1.0f,  1.0f, -1.0f,  -1.0f,  1.0f, -1.0f,
+		-1.0f, -1.0f,  1.0f,  -1.0f, -1.0f, -1.0f,  -1.0f,  1.0f, -1.0f,  -1.0f,  1.0f, -1.0f,  -1.0f,  1.0f,  1.0f,  -1.0f, -1.0f,  1.0f,
+		 1.0f, -1.0f, -1.0f,   1.0f, -1.0f,  1.0f,   1.0f,  1.0f,  1.0f,   1.0f,  1.0f,  1.0f,   1.0f,  1.0f, -1.0f,   1.0f, -1.0f, -1.0f,
+		-1.0f, -1.0f,  1.0f,  -1.0f,  1.0f,  1.0f,   1.0f,  1.0f,  1.0f,   1.0f,  1.0f,  1.0f,   1.0f, -1.0f,  1.0f,  -1.0f, -1.0f,  1.0f,
+		-1.0f,  1.0f, -1.0f,   1.0f,  1.0f, -1.0f,   1.0f,  1.0f,  1.0f,   1.0f,  1.0f,  1.0f,  -1.0f,  1.0f,  1.0f,  -1.0f,  1.0f, -1.0f,
+		-1.0f, -1.0f, -1.0f,  -1.0f, -1.0f,  1.0f,   1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,  -1.0f, -1.0f,  1.0f,   1.0f, -1.0f,  1.0f
+	};
+}
+
+Skybox::Skybox(const DecodedImage& image, Shader shader) : shader_{std::move(shader)}, cubemap_{loadCubemap(image)}, vao_{}, vertexBuffer_{}, vertexCount_{static_cast<int>(std::size(cubeVertices) / 3)}
+{
+	unsigned int vertexBuffer{};
+	glCreateBuffers(1, &vertexBuffer);
+	glNamedBufferStorage(vertexBuffer, sizeof(cubeVertices), cubeVertices, 0);
+	vertexBuffer_ = BufferHandle{vertexBuffer, sizeof(cubeVertices)};
+
+	unsigned int vao{};
+	glCreateVertexArrays(1, &vao);
+	glVertexArrayVertexBuffer(vao, 0, vertexBuffer, 0, 3 * sizeof(float));
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+	glVertexArrayAttribBinding(vao, 0, 0);
+	vao_ = VertexArrayHandle{vao};
+}
+
+// The vertex shader sets each vertex's depth to the far plane, so with a less-or-equal test the sky only passes where the depth buffer still holds its cleared value. Depth writes are disabled as nothing is drawn after the sky that could be hidden by it
+void Skybox::draw() const
+{
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_FALSE);
+
+	shader_.use();
+	glBindTextureUnit(TextureUnit, cubemap_.get());
+	glBindVertexArray(vao_.get());
+	glDrawArrays(GL_TRIANGLES, 0, vertexCount_);
+	glBindVertexArray(0);
+
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
+
+// Copy each face of an image laid out as a horizontal cross of faces into a layer of a cubemap, turning faces stored rotated in the cross into the orientation OpenGL expects
+TextureHandle Skybox::loadCubemap(const DecodedImage& image)
+{
+	unsigned int cubemap{};
+	glCreateTextures(GL_TEXTURE_CUBE_MAP, 1, &cubemap);
+
+	const auto texData{image.Data.get()};
+	const auto width{image.Width};
+	const auto height{image.Height};
+	const auto numComponents{image.Components};
+
+	// A cross is four faces wide and three tall, and may be padded vertically to make the texture square
+	const auto faceSize{width / 4};
+	if (!texData || numComponents < 3 || faceSize == 0 || height < faceSize * 3)
+	{
+		std::cout << "ERROR::SKYBOX::INVALID_TEXTURE: expected a horizontal cross of faces, got " << width << "x" << height << " with " << numComponents << " components\n";
+
+		return TextureHandle{cubemap};
+	}
+
+	const auto format{numComponents == 4 ? GL_RGBA : GL_RGB};
+	const auto crossStart{(height - faceSize * 3) / 2};
+
+	glTextureStorage2D(cubemap, 1, numComponents == 4 ? GL_RGBA8 : GL_RGB8, faceSize, faceSize);
+
+	std::vector<unsigned char> face(static_cast<std::size_t>(faceSize) * faceSize * numComponents);
+	for (auto i{0}; i < static_cast<int>(std::size(crossFaces)); ++i)
+	{
+		const auto& cell{crossFaces[i]};
+		const auto cellX{cell.Column * faceSize};
+		const auto cellY{crossStart + cell.Row * faceSize};
+
+		for (auto y{0}; y < faceSize; ++y)
+		{
+			for (auto x{0}; x < faceSize; ++x)
+			{
+				auto sourceX{x};
+				auto sourceY{y};
+				if (cell.Rotation == CellRotation::QUARTER)
+				{
+					sourceX = faceSize - 1 - y;
+					sourceY = x;
+				}
+				else if (cell.Rotation == CellRotation::THREE_QUARTER)
+				{
+					sourceX = y;
+					sourceY = faceSize - 1 - x;
+				}
+
+				const auto source{texData + (static_cast<std::size_t>(cellY + sourceY) * width + cellX + sourceX) * numComponents};
+				std::copy(source, source + numComponents, face.begin() + (static_cast<std::size_t>(y) * faceSize + x) * numComponents);
+			}
+		}
+
+		// Rows of three-component faces aren't necessarily four-byte aligned
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTextureSubImage3D(cubemap, 0, 0, 0, i, faceSize, faceSize, 1, format, GL_UNSIGNED_BYTE, face.data());
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	// The sky is never minified far enough to need mipmaps. Clamping stops texels from the opposite edge of a face bleeding into seams
+	glTextureParameteri(cubemap, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(cubemap, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(cubemap, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(cubemap, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(cubemap, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	return TextureHandle{cubemap, 6LL * faceSize * faceSize * (numComponents == 4 ? 4 : 3)};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "gpuresource.h"
+#include "image.h"
+#include "shader.h"
+
+// Class drawing the sky as a cubemap on a unit cube centred on the camera. The cube is drawn after all opaque geometry with its depth forced to the far plane, so the depth test rejects every pixel already covered and the sky is only shaded where nothing else was drawn.
+class Skybox
+{
+public:
+	// Build the cubemap from an image laid out as a horizontal cross, and create the cube drawn with it. The image can be decoded ahead of time, e.g., in the background while other assets load
+	Skybox(const DecodedImage& image, Shader shader);
+
+	// Draw the sky behind everything drawn so far. Reads the camera from the per-frame uniform buffer
+	void draw() const;
+
+	// Texture unit the cubemap is bound to, matching the binding declared in the skybox shader
+	static constexpr unsigned int TextureUnit{0};
+
+private:
+	Shader shader_;
+	TextureHandle cubemap_;
+	VertexArrayHandle vao_;
+	BufferHandle vertexBuffer_;
+	int vertexCount_;
+
+	static TextureHandle loadCubemap(const DecodedImage& image);
+};
@@ -0,0 +1,160 @@
+#include "staticbvh.h"
+#include "bounds.h"
+#include "gameobject.h"
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+
+namespace
+{
+	// Leaves hold up to this many objects, trading a few extra box tests for a shallower tree
+	constexpr auto maxLeafSize{4};
+
+	// Deepest traversal stack needed by a query -- median splits keep the tree balanced
+	constexpr auto maxStackSize{64};
+}
+
+StaticBvh::StaticBvh() : nodes_{}, boxes_{}, objects_{}
+{
+}
+
+// Copy the objects' boxes and recursively split them into a tree
+void StaticBvh::build(const std::vector<GameObject*>& objects)
+{
+	nodes_.clear();
+	boxes_.clear();
+	objects_ = objects;
+
+	for (const auto obj : objects_)
+	{
+		const auto& position{obj->getPosition()};
+		boxes_.push_back(Box{position, position + obj->getSize()});
+	}
+
+	if (objects_.empty())
+		return;
+
+	// A binary tree with at most maxLeafSize objects per leaf needs fewer than 2n nodes
+	nodes_.reserve(2 * objects_.size());
+	buildNode(0, static_cast<int>(objects_.size()));
+}
+
+void StaticBvh::query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const
+{
+	queryTree([&min, &max](const glm::vec3& nodeMin, const glm::vec3& nodeMax) { return overlapsBox(nodeMin, nodeMax, min, max); }, results);
+}
+
+void StaticBvh::querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const
+{
+	const auto radiusSquared{radius * radius};
+
+	queryTree([&centre, radiusSquared](const glm::vec3& nodeMin, const glm::vec3& nodeMax) { return overlapsSphere(nodeMin, nodeMax, centre, radiusSquared); }, results);
+}
+
+void StaticBvh::queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const
+{
+	const auto inverseDirection{1.0f / direction};
+
+	queryTree([&origin, &inverseDirection, maxDistance](const glm::vec3& nodeMin, const glm::vec3& nodeMax) { return overlapsRay(nodeMin, nodeMax, origin, inverseDirection, maxDistance); }, results);
+}
+
+// Create a node covering the given range of objects, splitting it at the median along the longest axis of the object centres. Returns the index of the node
+int StaticBvh::buildNode(int first, int count)
+{
+	const auto index{static_cast<int>(nodes_.size())};
+	nodes_.emplace_back();
+
+	auto nodeMin{boxes_[first].Min};
+	auto nodeMax{boxes_[first].Max};
+	auto centreMin{boxes_[first].Min + boxes_[first].Max};
+	auto centreMax{centreMin};
+	for (auto i{first + 1}; i < first + count; ++i)
+	{
+		nodeMin = glm::min(nodeMin, boxes_[i].Min);
+		nodeMax = glm::max(nodeMax, boxes_[i].Max);
+
+		// Centres are kept doubled, as only their relative order matters
+		const auto centre{boxes_[i].Min + boxes_[i].Max};
+		centreMin = glm::min(centreMin, centre);
+		centreMax = glm::max(centreMax, centre);
+	}
+
+	nodes_[index].Min = nodeMin;
+	nodes_[index].Max = nodeMax;
+
+	if (count <= maxLeafSize)
+	{
+		nodes_[index].Offset = first;
+		nodes_[index].Count = count;
+
+		return index;
+	}
+
+	const auto extent{centreMax - centreMin};
+	const auto axis{extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2};
+
+	// Partition the boxes and objects together around the median centre
+	std::vector<int> order(count);
+	std::iota(order.begin(), order.end(), first);
+	const auto middle{count / 2};
+	std::nth_element(order.begin(), order.begin() + middle, order.end(), [this, axis](int a, int b)
+	{
+		return boxes_[a].Min[axis] + boxes_[a].Max[axis] < boxes_[b].Min[axis] + boxes_[b].Max[axis];
+	});
+
+	std::vector<Box> sortedBoxes{};
+	std::vector<GameObject*> sortedObjects{};
+	sortedBoxes.reserve(count);
+	sortedObjects.reserve(count);
+	for (const auto i : order)
+	{
+		sortedBoxes.push_back(boxes_[i]);
+		sortedObjects.push_back(objects_[i]);
+	}
+	std::copy(sortedBoxes.begin(), sortedBoxes.end(), boxes_.begin() + first);
+	std::copy(sortedObjects.begin(), sortedObjects.end(), objects_.begin() + first);
+
+	// Left child is always stored directly after its parent
+	buildNode(first, middle);
+	nodes_[index].Offset = buildNode(first + middle, count - middle);
+	nodes_[index].Count = 0;
+
+	return index;
+}
+
+// Walk the tree, descending only into nodes accepted by the overlap test, and test each object in accepted leaves
+template<typename Overlaps>
+void StaticBvh::queryTree(const Overlaps& overlaps, std::vector<GameObject*>& results) const
+{
+	if (nodes_.empty())
+		return;
+
+	int stack[maxStackSize]{};
+	auto stackSize{0};
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0)
+	{
+		const auto index{stack[--stackSize]};
+		const auto& node{nodes_[index]};
+
+		if (!overlaps(node.Min, node.Max))
+			continue;
+
+		if (node.Count > 0)
+		{
+			for (auto i{node.Offset}; i < node.Offset + node.Count; ++i)
+			{
+				if (overlaps(boxes_[i].Min, boxes_[i].Max))
+					results.push_back(objects_[i]);
+			}
+		}
+		else
+		{
+			assert(stackSize + 2 <= maxStackSize);
+
+			stack[stackSize++] = node.Offset;
+			stack[stackSize++] = index + 1;
+		}
+	}
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <vector>
+
+class GameObject;
+
+// Class representing an immutable bounding volume hierarchy over the collision boxes of objects that never move. The tree is built once and flattened into a single array in depth-first order, so each node is 32 bytes, left children immediately follow their parents, and traversal walks memory mostly forwards.
+class StaticBvh
+{
+public:
+	StaticBvh();
+
+	// Build the hierarchy over the given objects, replacing any previous contents. Objects must not move afterwards
+	void build(const std::vector<GameObject*>& objects);
+
+	void query(const glm::vec3& min, const glm::vec3& max, std::vector<GameObject*>& results) const;
+	void querySphere(const glm::vec3& centre, float radius, std::vector<GameObject*>& results) const;
+	void queryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, std::vector<GameObject*>& results) const;
+
+	int getObjectCount() const
+	{
+		return static_cast<int>(objects_.size());
+	}
+
+private:
+	struct Node
+	{
+		glm::vec3 Min{};
+
+		// Index of the right child for internal nodes, or of the first object for leaves
+		int Offset{};
+
+		glm::vec3 Max{};
+
+		// Number of objects in a leaf, zero for internal nodes
+		int Count{};
+	};
+
+	struct Box
+	{
+		glm::vec3 Min{};
+		glm::vec3 Max{};
+	};
+
+	std::vector<Node> nodes_;
+
+	// Object boxes and objects, reordered so each leaf's objects are contiguous
+	std::vector<Box> boxes_;
+	std::vector<GameObject*> objects_;
+
+	int buildNode(int first, int count);
+
+	template<typename Overlaps>
+	void queryTree(const Overlaps& overlaps, std::vector<GameObject*>& results) const;
+};
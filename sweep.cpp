@@ -0,0 +1,231 @@
+#include "sweep.h"
+#include <glm/geometric.hpp>
+#include <glm/common.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Swept sphere versus box is equivalent to a ray versus the box expanded by the sphere's radius with rounded edges and corners. The approach follows Real-Time Collision Detection by Christer Ericson, section 5.5.7
+namespace
+{
+	// Earliest time in [0, 1] at which a ray starting outside the sphere touches it
+	bool intersectRaySphere(const glm::vec3& start, const glm::vec3& displacement, const glm::vec3& centre, float radius, float& time)
+	{
+		const auto offset{start - centre};
+		const auto a{dot(displacement, displacement)};
+		const auto b{dot(offset, displacement)};
+		const auto c{dot(offset, offset) - radius * radius};
+
+		// Moving away from the sphere or not moving at all
+		if (b > 0.0f || a == 0.0f)
+			return false;
+
+		const auto discriminant{b * b - a * c};
+		if (discriminant < 0.0f)
+			return false;
+
+		time = std::max((-b - std::sqrt(discriminant)) / a, 0.0f);
+
+		return time <= 1.0f;
+	}
+
+	// Earliest time in [0, 1] at which a ray touches the side of a cylinder running along the given axis from edgeStart, or either of its rounded ends
+	bool intersectRayEdge(const glm::vec3& start, const glm::vec3& displacement, const glm::vec3& edgeStart, int axis, float length, float radius, float& time)
+	{
+		auto hit{false};
+		time = std::numeric_limits<float>::max();
+
+		// Side of the cylinder -- only the two axes perpendicular to the edge matter
+		const auto i{(axis + 1) % 3};
+		const auto j{(axis + 2) % 3};
+		const auto offsetI{start[i] - edgeStart[i]};
+		const auto offsetJ{start[j] - edgeStart[j]};
+		const auto a{displacement[i] * displacement[i] + displacement[j] * displacement[j]};
+		const auto b{offsetI * displacement[i] + offsetJ * displacement[j]};
+		const auto c{offsetI * offsetI + offsetJ * offsetJ - radius * radius};
+		const auto discriminant{b * b - a * c};
+
+		if (a > 0.0f && b <= 0.0f && discriminant >= 0.0f)
+		{
+			const auto t{std::max((-b - std::sqrt(discriminant)) / a, 0.0f)};
+			const auto along{start[axis] + displacement[axis] * t - edgeStart[axis]};
+
+			if (t <= 1.0f && along >= 0.0f && along <= length)
+			{
+				time = t;
+				hit = true;
+			}
+		}
+
+		// Rounded ends of the edge
+		auto edgeEnd{edgeStart};
+		edgeEnd[axis] += length;
+
+		auto t{0.0f};
+		if (intersectRaySphere(start, displacement, edgeStart, radius, t) && t < time)
+		{
+			time = t;
+			hit = true;
+		}
+
+		if (intersectRaySphere(start, displacement, edgeEnd, radius, t) && t < time)
+		{
+			time = t;
+			hit = true;
+		}
+
+		return hit;
+	}
+
+	// Get the box corner selected by the bits of n, with a set bit selecting the maximum on that axis
+	glm::vec3 getCorner(const glm::vec3& boxMin, const glm::vec3& boxMax, int n)
+	{
+		return glm::vec3
+		{
+			n & 1 ? boxMax.x : boxMin.x,
+			n & 2 ? boxMax.y : boxMin.y,
+			n & 4 ? boxMax.z : boxMin.z
+		};
+	}
+
+	// Test the edge between two corners that differ on exactly one axis
+	bool intersectRayCornerEdge(const glm::vec3& start, const glm::vec3& displacement, const glm::vec3& boxMin, const glm::vec3& boxMax, int cornerA, int cornerB, float radius, float& time)
+	{
+		const auto axis{(cornerA ^ cornerB) == 1 ? 0 : (cornerA ^ cornerB) == 2 ? 1 : 2};
+		const auto edgeStart{getCorner(boxMin, boxMax, cornerA & cornerB)};
+
+		return intersectRayEdge(start, displacement, edgeStart, axis, boxMax[axis] - boxMin[axis], radius, time);
+	}
+
+	// Normal pointing from the closest point on the box to the sphere centre, or out of the nearest face if the centre is inside the box
+	glm::vec3 getContactNormal(const glm::vec3& centre, const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		const auto offset{centre - clamp(centre, boxMin, boxMax)};
+		const auto distanceSquared{dot(offset, offset)};
+
+		if (distanceSquared > 0.0f)
+			return offset / std::sqrt(distanceSquared);
+
+		auto normal{glm::vec3{0.0f}};
+		auto smallestDepth{std::numeric_limits<float>::max()};
+		for (auto axis{0}; axis < 3; ++axis)
+		{
+			const auto depthMin{centre[axis] - boxMin[axis]};
+			const auto depthMax{boxMax[axis] - centre[axis]};
+
+			if (depthMin < smallestDepth)
+			{
+				smallestDepth = depthMin;
+				normal = glm::vec3{0.0f};
+				normal[axis] = -1.0f;
+			}
+
+			if (depthMax < smallestDepth)
+			{
+				smallestDepth = depthMax;
+				normal = glm::vec3{0.0f};
+				normal[axis] = 1.0f;
+			}
+		}
+
+		return normal;
+	}
+}
+
+SweepHit sweepSphereAabb(const glm::vec3& centre, const glm::vec3& displacement, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax)
+{
+	SweepHit result{};
+
+	// Already overlapping -- only block movement that goes further into the box
+	const auto offset{centre - clamp(centre, boxMin, boxMax)};
+	if (dot(offset, offset) < radius * radius)
+	{
+		const auto normal{getContactNormal(centre, boxMin, boxMax)};
+
+		if (dot(displacement, normal) < 0.0f)
+		{
+			result.Hit = true;
+			result.Time = 0.0f;
+			result.Normal = normal;
+		}
+
+		return result;
+	}
+
+	// Slab test against the box expanded by the radius on every side
+	const auto expandedMin{boxMin - radius};
+	const auto expandedMax{boxMax + radius};
+	auto entry{0.0f};
+	auto exit{1.0f};
+	for (auto axis{0}; axis < 3; ++axis)
+	{
+		if (displacement[axis] == 0.0f)
+		{
+			if (centre[axis] < expandedMin[axis] || centre[axis] > expandedMax[axis])
+				return result;
+
+			continue;
+		}
+
+		const auto inverse{1.0f / displacement[axis]};
+		auto t1{(expandedMin[axis] - centre[axis]) * inverse};
+		auto t2{(expandedMax[axis] - centre[axis]) * inverse};
+		if (t1 > t2)
+			std::swap(t1, t2);
+
+		entry = std::max(entry, t1);
+		exit = std::min(exit, t2);
+
+		if (entry > exit)
+			return result;
+	}
+
+	// Classify the entry point by which axes it lies outside the original box on
+	const auto point{centre + displacement * entry};
+	auto below{0};
+	auto above{0};
+	for (auto axis{0}; axis < 3; ++axis)
+	{
+		if (point[axis] < boxMin[axis])
+			below |= 1 << axis;
+		if (point[axis] > boxMax[axis])
+			above |= 1 << axis;
+	}
+
+	const auto outside{below + above};
+	auto time{entry};
+
+	if (outside == 7)
+	{
+		// Corner region -- the hit must be on one of the three edges meeting at the corner
+		auto hit{false};
+		auto best{std::numeric_limits<float>::max()};
+		for (const auto axisBit : {1, 2, 4})
+		{
+			auto t{0.0f};
+			if (intersectRayCornerEdge(centre, displacement, boxMin, boxMax, above, above ^ axisBit, radius, t) && t < best)
+			{
+				best = t;
+				hit = true;
+			}
+		}
+
+		if (!hit)
+			return result;
+
+		time = best;
+	}
+	else if ((outside & (outside - 1)) != 0)
+	{
+		// Edge region -- the hit must be on the edge shared by the two faces
+		if (!intersectRayCornerEdge(centre, displacement, boxMin, boxMax, below ^ 7, above, radius, time))
+			return result;
+	}
+
+	// Otherwise the entry point is in a face region, so the slab entry time is exact
+	result.Hit = true;
+	result.Time = time;
+	result.Normal = getContactNormal(centre + displacement * time, boxMin, boxMax);
+
+	return result;
+}
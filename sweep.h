@@ -0,0 +1,14 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+// Result of sweeping a shape through the world. Time is the fraction of the sweep's displacement travelled before first contact, and Normal points away from the surface that was hit
+struct SweepHit
+{
+	bool Hit{false};
+	float Time{1.0f};
+	glm::vec3 Normal{0.0f};
+};
+
+// Sweep a sphere from the given centre along displacement against an axis-aligned box, finding the time of first impact. The sweep is continuous, so thin boxes can't be skipped over regardless of speed. If the sphere starts overlapping the box, a hit at time zero is reported only when the sphere is moving further into the box
+SweepHit sweepSphereAabb(const glm::vec3& centre, const glm::vec3& displacement, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax);
@@ -0,0 +1,120 @@
+// Randomised test checking ColliderStore's batched sphere test agrees exactly with its scalar path and with checkSphereBox. Built separately from the game, e.g., from the project root:
+//   g++ -std=c++17 -O2 -I. tests/collisiontest.cpp colliderstore.cpp collision.cpp -o collisiontest
+// Add -mavx2 to test the AVX2 path rather than the SSE path (cl: /arch:AVX2). Exits with a non-zero status on any mismatch
+#include "colliderstore.h"
+#include "collision.h"
+#include <cstdio>
+#include <random>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+	constexpr auto maxBoxCount{40};
+	constexpr auto roundsPerCount{2000};
+
+	struct Box
+	{
+		glm::vec3 Position{};
+		glm::vec3 Size{};
+	};
+
+	// Compare every way of testing the sphere against the boxes, reporting the first box they disagree on
+	bool testSphere(const std::vector<Box>& boxes, const glm::vec3& centre, float radius)
+	{
+		auto store{ColliderStore{}};
+		for (const auto& box : boxes)
+			store.add(box.Position, box.Size);
+
+		std::vector<int> batched{};
+		std::vector<int> scalar{};
+		store.testSphere(centre, radius, batched);
+		store.testSphereScalar(centre, radius, scalar);
+
+		std::vector<int> expected{};
+		for (auto i{0}; i < static_cast<int>(boxes.size()); ++i)
+		{
+			if (std::get<0>(checkSphereBox(centre, radius, boxes[i].Position, boxes[i].Size)))
+				expected.push_back(i);
+		}
+
+		if (batched == expected && scalar == expected)
+			return true;
+
+		std::printf("Mismatch with %d boxes, sphere (%g, %g, %g) radius %g: batched %d hits, scalar %d hits, expected %d hits\n",
+			static_cast<int>(boxes.size()), centre.x, centre.y, centre.z, radius,
+			static_cast<int>(batched.size()), static_cast<int>(scalar.size()), static_cast<int>(expected.size()));
+
+		return false;
+	}
+
+	// Place the sphere exactly touching a face, edge or corner of the box, or just inside or outside it, where rounding decides the result
+	glm::vec3 touchingCentre(const Box& box, float radius, std::mt19937& random)
+	{
+		std::uniform_int_distribution<int> side{-1, 1};
+		std::uniform_int_distribution<int> nudge{-1, 1};
+
+		auto centre{box.Position + box.Size / 2.0f};
+		for (auto axis{0}; axis < 3; ++axis)
+		{
+			const auto offset{side(random)};
+			if (offset < 0)
+				centre[axis] = box.Position[axis] - radius;
+			else if (offset > 0)
+				centre[axis] = box.Position[axis] + box.Size[axis] + radius;
+		}
+
+		// Step to neighbouring floats, so both sides of the boundary are covered
+		const auto steps{nudge(random)};
+		for (auto axis{0}; axis < 3; ++axis)
+			centre[axis] = steps < 0 ? std::nextafter(centre[axis], -1e9f) : steps > 0 ? std::nextafter(centre[axis], 1e9f) : centre[axis];
+
+		return centre;
+	}
+}
+
+int main()
+{
+	std::mt19937 random{12345};
+	std::uniform_real_distribution<float> position{-10.0f, 10.0f};
+	std::uniform_real_distribution<float> size{0.0f, 4.0f};
+	std::uniform_real_distribution<float> radius{0.05f, 3.0f};
+	std::uniform_int_distribution<int> coin{0, 1};
+
+	auto failures{0};
+
+	// Every count up to several SIMD widths, so full batches and every length of scalar tail are covered
+	for (auto count{0}; count <= maxBoxCount; ++count)
+	{
+		for (auto round{0}; round < roundsPerCount; ++round)
+		{
+			std::vector<Box> boxes(count);
+			for (auto& box : boxes)
+			{
+				box.Position = glm::vec3{position(random), position(random), position(random)};
+				box.Size = glm::vec3{size(random), size(random), size(random)};
+			}
+
+			// Some boxes are flat, as platforms of zero thickness are valid
+			if (count > 0 && coin(random))
+				boxes[random() % count].Size.y = 0.0f;
+
+			const auto sphereRadius{radius(random)};
+			const auto centre{count > 0 && coin(random) ? touchingCentre(boxes[random() % count], sphereRadius, random) : glm::vec3{position(random), position(random), position(random)}};
+
+			if (!testSphere(boxes, centre, sphereRadius))
+				++failures;
+		}
+	}
+
+	if (failures > 0)
+	{
+		std::printf("%d of %d tests failed\n", failures, (maxBoxCount + 1) * roundsPerCount);
+
+		return 1;
+	}
+
+	std::printf("All %d tests passed\n", (maxBoxCount + 1) * roundsPerCount);
+
+	return 0;
+}
@@ -1,11 +1,14 @@
 #include "visibleobject.h"
+#include "instancedrenderer.h"
 #include <glm/fwd.hpp>
+#include <glm/common.hpp>
 #include <glm/ext/matrix_transform.hpp>
+#include <glm/matrix.hpp>
 #include <utility>
 
 VisibleObject::VisibleObject
 (
-	Model model,
+	std::shared_ptr<const Model> model,
 	Shader shader,
 	const glm::vec3& position,
 	const glm::vec3& size,
@@ -16,12 +19,29 @@ VisibleObject::VisibleObject
 	model_{std::move(model)},
 	scale_{scale},
 	offset_{offset},
-	shader_{shader}
+	shader_{std::move(shader)},
+	normalMatrix_{calculateNormalMatrix()},
+	lod_{0}
 {
 }
 
-// Calculate transform for the model and then render it using the provided shader
-void VisibleObject::draw() const
+// Queue the model to be rendered with the object's shader and transform, at a level of detail suited to its size on screen. Objects sharing a model and shader are drawn together
+void VisibleObject::draw(InstancedRenderer& renderer) const
+{
+	// Skip objects hidden behind occluders before doing any other work for them
+	glm::vec3 min{};
+	glm::vec3 max{};
+	getWorldBounds(min, max);
+	if (renderer.isOccluded(min, max))
+		return;
+
+	const auto transform{getModelMatrix()};
+	lod_ = renderer.selectLod(*model_, transform, lod_);
+	renderer.submit(*model_, shader_, transform, normalMatrix_, lod_);
+}
+
+// Calculate transform for the model from the object's position, offset, and scale
+glm::mat4 VisibleObject::getModelMatrix() const
 {
 	auto transform{glm::mat4{1.0f}};
 
@@ -32,5 +52,44 @@ void VisibleObject::draw() const
 
 	transform = scale(transform, scale_);
 
-	model_.draw(shader_, transform);
+	return transform;
+}
+
+// Occluders lie inside the model, so an object can never be hidden by its own occluder
+void VisibleObject::getWorldBounds(glm::vec3& min, glm::vec3& max) const
+{
+	const auto& bounds{model_->getBounds()};
+	transformBounds(bounds.Min, bounds.Max, min, max);
+}
+
+const Model& VisibleObject::getModel() const
+{
+	return *model_;
+}
+
+// Transform every corner, as the box's extremes in world space needn't come from its extremes in model space
+void VisibleObject::transformBounds(const glm::vec3& modelMin, const glm::vec3& modelMax, glm::vec3& min, glm::vec3& max) const
+{
+	const auto transform{getModelMatrix()};
+	for (auto i{0}; i < 8; ++i)
+	{
+		const auto corner{glm::vec3{i & 1 ? modelMax.x : modelMin.x, i & 2 ? modelMax.y : modelMin.y, i & 4 ? modelMax.z : modelMin.z}};
+		const auto world{glm::vec3{transform * glm::vec4{corner, 1.0f}}};
+		min = i == 0 ? world : glm::min(min, world);
+		max = i == 0 ? world : glm::max(max, world);
+	}
+}
+
+const glm::mat3& VisibleObject::getNormalMatrix() const
+{
+	return normalMatrix_;
+}
+
+// Normals are transformed by the inverse transpose of the model matrix's upper 3x3. With uniform scale that is a multiple of the identity, and the fragment shader normalises normals anyway, so the identity can be used without inverting anything
+glm::mat3 VisibleObject::calculateNormalMatrix() const
+{
+	if (scale_.x == scale_.y && scale_.y == scale_.z)
+		return glm::mat3{1.0f};
+
+	return glm::transpose(glm::inverse(glm::mat3{getModelMatrix()}));
 }
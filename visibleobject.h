@@ -3,19 +3,45 @@
 #include "gameobject.h"
 #include "model.h"
 #include "shader.h"
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
+#include <memory>
 
 // Class representing a GameObject that is represented visually with 3D model. Includes functionality for drawing the model and settings it scale and offset relative to its containing GameObject instance.
 class VisibleObject : public GameObject
 {
 public:
-	VisibleObject(Model model, Shader shader, const glm::vec3& position, const glm::vec3& size, const glm::vec3& offset = glm::vec3{0.0}, const glm::vec3& scale = glm::vec3{1.0});
+	VisibleObject(std::shared_ptr<const Model> model, Shader shader, const glm::vec3& position, const glm::vec3& size, const glm::vec3& offset = glm::vec3{0.0}, const glm::vec3& scale = glm::vec3{1.0});
 
-	virtual void draw() const override;
+	virtual void draw(InstancedRenderer& renderer) const override;
+
+	// Get the matrix transforming the model into world space
+	glm::mat4 getModelMatrix() const;
+
+	// Get the world space box enclosing the model
+	void getWorldBounds(glm::vec3& min, glm::vec3& max) const;
+
+	// Get the matrix transforming the model's normals into world space
+	const glm::mat3& getNormalMatrix() const;
+
+	const Model& getModel() const;
+
+protected:
+	// Get the world space box enclosing a box given in model space
+	void transformBounds(const glm::vec3& modelMin, const glm::vec3& modelMax, glm::vec3& min, glm::vec3& max) const;
 
 private:
-	Model model_;
+	std::shared_ptr<const Model> model_;
 	glm::vec3 scale_;
 	glm::vec3 offset_;
 	Shader shader_;
+
+	// The normal matrix ignores translation, so it only changes with scale, which is fixed at construction. Calculated once rather than per frame or per vertex
+	glm::mat3 normalMatrix_;
+
+	// Level of detail the model was last drawn at, which selection depends on to avoid switching back and forth. Only affects how the object is drawn, so may change while drawing
+	mutable int lod_;
+
+	glm::mat3 calculateNormalMatrix() const;
 };